@@ -0,0 +1,66 @@
+#ifndef ACCIO_CORE_ALIGNEDBUFFER_HPP_
+#define ACCIO_CORE_ALIGNEDBUFFER_HPP_
+
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <sys/mman.h>
+
+
+namespace ACCIO::CORE
+{
+
+  // note: 別のスレッドが更新する変数を別のキャッシュラインに置き，偽共有を避けるために使う．
+  constexpr std::size_t cache_line_size = 64;
+
+  class AlignedDeleter
+  {
+  private:
+
+    std::size_t alignment_;
+
+  public:
+
+    explicit AlignedDeleter(std::size_t alignment = alignof(std::max_align_t)) noexcept:
+      alignment_(alignment)
+    {}
+
+    void operator()(void* p) const noexcept
+    {
+      ::operator delete[](p, std::align_val_t(alignment_));
+    }
+
+  };
+
+  /// ページ境界に揃えた配列．
+  template<class T>
+  using AlignedArray = std::unique_ptr<T[], AlignedDeleter>;
+
+  /// n 要素の AlignedArray を確保する．要素は初期化しない．
+  /// 大きな配列は透過的ヒュージページの大きさ（2 MiB）に揃え，ヒュージページを使うように促す．
+  template<class T>
+  AlignedArray<T> make_aligned_array(std::size_t n)
+  {
+    static_assert(std::is_trivial_v<T>);
+    constexpr std::size_t page_size = 1 << 12;
+    constexpr std::size_t huge_page_size = 1 << 21;
+    auto bytes = n * sizeof(T);
+    auto alignment = bytes >= huge_page_size ? huge_page_size : page_size;
+    // note: 末尾のページを他の領域と共有しないように，大きさも alignment の倍数に切り上げる．
+    bytes = (bytes + alignment - 1) / alignment * alignment;
+    void* p = ::operator new[](bytes, std::align_val_t(alignment));
+#ifdef MADV_HUGEPAGE
+    if(alignment == huge_page_size){
+      // note: ヒュージページを使えない環境ではエラーとなるが，無視する．
+      ::madvise(p, bytes, MADV_HUGEPAGE);
+    }
+#endif
+    return AlignedArray<T>(static_cast<T*>(p), AlignedDeleter(alignment));
+  }
+
+}
+
+
+#endif
@@ -0,0 +1,149 @@
+#ifndef ACCIO_CORE_ARENA_HPP_
+#define ACCIO_CORE_ARENA_HPP_
+
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+
+namespace ACCIO::CORE
+{
+
+  /// 領域を先頭から順に切り出すだけのアロケータ（バンプアロケータ）．個別の解放は行わず，reset() でまとめて解放する．
+  class Arena
+  {
+  private:
+
+    static constexpr std::size_t default_block_size = 1 << 16;
+
+    std::vector<std::unique_ptr<std::byte[]>> blocks_;
+    std::byte* current_;
+    std::size_t rest_;
+    std::size_t block_size_;
+    // reset() してから確保した大きさの合計．
+    std::size_t used_;
+
+    void add_block(std::size_t size)
+    {
+      blocks_.push_back(std::make_unique<std::byte[]>(size));
+      current_ = blocks_.back().get();
+      rest_ = size;
+    }
+
+  public:
+
+    explicit Arena(std::size_t block_size = default_block_size):
+      blocks_(), current_(nullptr), rest_(0), block_size_(std::max<std::size_t>(block_size, 1)), used_(0)
+    {}
+
+    /// alignment に揃えた n バイトの領域を返す．
+    void* allocate(std::size_t n, std::size_t alignment = alignof(std::max_align_t))
+    {
+      auto padding = (alignment - reinterpret_cast<std::uintptr_t>(current_) % alignment) % alignment;
+      if(current_ == nullptr || padding + n > rest_){
+        // note: ブロックは再確保しないので，足りなくなったら倍の大きさのブロックを追加する．
+        block_size_ = std::max(blocks_.empty() ? block_size_ : block_size_ * 2, n + alignment);
+        add_block(block_size_);
+        padding = (alignment - reinterpret_cast<std::uintptr_t>(current_) % alignment) % alignment;
+      }
+      auto result = current_ + padding;
+      current_ += padding + n;
+      rest_ -= padding + n;
+      used_ += padding + n;
+      return result;
+    }
+
+    /// 確保したすべての領域を解放する．
+    /// 複数のブロックを使っていた場合は，それらを合わせた大きさの 1 つのブロックに置き換えて，次回は連続した領域に収まるようにする．
+    void reset()
+    {
+      if(blocks_.size() > 1){
+        auto size = std::max(used_, block_size_);
+        blocks_.clear();
+        block_size_ = size;
+        add_block(size);
+      }else if(!blocks_.empty()){
+        current_ = blocks_.back().get();
+        rest_ = block_size_;
+      }
+      used_ = 0;
+    }
+
+    /// reset() してから確保した大きさの合計を返す．
+    std::size_t used() const noexcept
+    {
+      return used_;
+    }
+
+  // deleted:
+
+    Arena(Arena&&) = delete;
+    Arena(const Arena&) = delete;
+    Arena& operator=(Arena&&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+  };
+
+  /// Arena から領域を確保する標準ライブラリ互換のアロケータ．deallocate() は何もしない．
+  template<class T>
+  class ArenaAllocator
+  {
+    template<class>
+    friend class ArenaAllocator;
+
+  public:
+
+    using value_type = T;
+
+  private:
+
+    Arena* arena_;
+
+  public:
+
+    explicit ArenaAllocator(Arena& arena) noexcept:
+      arena_(&arena)
+    {}
+
+    template<class U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept:
+      arena_(other.arena_)
+    {}
+
+    T* allocate(std::size_t n)
+    {
+      return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, std::size_t) noexcept
+    {
+      // 何もしない．
+    }
+
+    template<class U>
+    bool operator==(const ArenaAllocator<U>& rhs) const noexcept
+    {
+      return arena_ == rhs.arena_;
+    }
+
+    template<class U>
+    bool operator!=(const ArenaAllocator<U>& rhs) const noexcept
+    {
+      return arena_ != rhs.arena_;
+    }
+
+  // deleted:
+
+    ArenaAllocator() = delete;
+
+  };
+
+}
+
+
+#endif
@@ -0,0 +1,303 @@
+#ifndef ACCIO_CORE_ASYNCCSVPARSER_HPP_
+#define ACCIO_CORE_ASYNCCSVPARSER_HPP_
+
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+#include "CSVParser.hpp"
+#include "Coroutine.hpp"
+#include "Decoder.hpp"
+#include "Reactor.hpp"
+#include "SIMD.hpp"
+
+
+#ifdef ACCIO_CORE_HAS_COROUTINE
+
+
+namespace ACCIO::CORE
+{
+
+  /// ノンブロッキングなファイル記述子（パイプ，ソケット等）から読み込む入力．読めるデータがない場合は Reactor で待つ．
+  /// InputStream と同様に peek_span() と consume() で読み進め，足りなくなったら co_await refill() で読み足す．
+  template<class CharT>
+  class AsyncInputStream
+  {
+    static_assert(sizeof(CharT) == 1);
+
+  public:
+
+    using char_type = CharT;
+
+    static constexpr std::size_t default_buffer_size = 1 << 16;
+
+  private:
+
+    Reactor* reactor_;
+    int fd_;
+    std::unique_ptr<char_type[]> buffer_;
+    std::size_t capacity_;
+    // [first_, last_) が読み込んだがまだ読み進めていない部分．
+    std::size_t first_;
+    std::size_t last_;
+    bool eof_;
+
+  public:
+
+    /// fd の所有権を引き取り，ノンブロッキングに設定する．
+    AsyncInputStream(Reactor& reactor, int fd, std::size_t buffer_size = default_buffer_size):
+      reactor_(&reactor), fd_(fd), buffer_(std::make_unique<char_type[]>(std::max<std::size_t>(buffer_size, 1))),
+      capacity_(std::max<std::size_t>(buffer_size, 1)), first_(0), last_(0), eof_(false)
+    {
+      auto flags = ::fcntl(fd_, F_GETFL);
+      if(flags < 0 || ::fcntl(fd_, F_SETFL, flags | O_NONBLOCK) != 0){
+        close();
+        throw std::runtime_error("fcntl() failure.");
+      }
+    }
+
+    AsyncInputStream(AsyncInputStream&& other) noexcept:
+      reactor_(other.reactor_), fd_(std::exchange(other.fd_, -1)), buffer_(std::move(other.buffer_)), capacity_(other.capacity_),
+      first_(other.first_), last_(other.last_), eof_(other.eof_)
+    {}
+
+    ~AsyncInputStream() noexcept
+    {
+      close();
+    }
+
+    void close() noexcept
+    {
+      if(fd_ >= 0){
+        ::close(fd_);
+        fd_ = -1;
+      }
+    }
+
+    /// 入力の終わりに達し，全て読み進めたか．
+    bool eof() const noexcept
+    {
+      return eof_ && first_ == last_;
+    }
+
+    /// 入力の終わりまで読み込んだか（読み進めていない部分が残っていてもよい）．
+    bool reached_eof() const noexcept
+    {
+      return eof_;
+    }
+
+    std::basic_string_view<char_type> peek_span() const noexcept
+    {
+      return std::basic_string_view<char_type>(buffer_.get() + first_, last_ - first_);
+    }
+
+    void consume(std::size_t n) noexcept
+    {
+      assert(n <= last_ - first_);
+      first_ += n;
+    }
+
+    /// 入力を読み足す．読めるデータがない場合は，読めるようになるまで待つ．入力の終わりに達していた場合は false を返す．
+    /// note: 読み進めていない部分を先頭に詰めるので，それまでに peek_span() で得た領域は無効になる．
+    Task<bool> refill()
+    {
+      if(eof_) co_return false;
+      if(first_ != 0){
+        std::memmove(buffer_.get(), buffer_.get() + first_, last_ - first_);
+        last_ -= first_;
+        first_ = 0;
+      }
+      if(last_ == capacity_){
+        auto buffer = std::make_unique<char_type[]>(capacity_ * 2);
+        std::memcpy(buffer.get(), buffer_.get(), last_);
+        buffer_ = std::move(buffer);
+        capacity_ *= 2;
+      }
+      while(true){
+        auto n = ::read(fd_, buffer_.get() + last_, capacity_ - last_);
+        if(n > 0){
+          last_ += static_cast<std::size_t>(n);
+          co_return true;
+        }else if(n == 0){
+          eof_ = true;
+          co_return false;
+        }else if(errno == EAGAIN || errno == EWOULDBLOCK){
+          co_await reactor_->readable(fd_);
+        }else if(errno != EINTR){
+          throw std::runtime_error("read() failure.");
+        }
+      }
+    }
+
+  // deleted:
+
+    AsyncInputStream() = delete;
+    AsyncInputStream(const AsyncInputStream&) = delete;
+    AsyncInputStream& operator=(AsyncInputStream&&) = delete;
+    AsyncInputStream& operator=(const AsyncInputStream&) = delete;
+
+  };
+
+  /// AsyncInputStream を CSVParser と同様に解析する．records() が返す AsyncGenerator からレコードを 1 つずつ受け取る．
+  /// 読み込んだ入力のうち，囲み文字の外側の最後の LF までの完全なレコードのみを同期的な解析器（CSVParser の BlockImpl）に渡し，
+  /// それを読み終えたら次の入力を待つ．したがって，レコードの途中で読み込みを待つことはない．
+  /// note: 入力は encoding（"ascii", "utf-8" 等）として検証するが，変換はしない．
+  template<class CharT>
+  class AsyncCSVParser
+  {
+    static_assert(sizeof(CharT) == 1);
+
+  public:
+
+    using char_type = CharT;
+    using Record = CSVRecord<char_type>;
+
+  private:
+
+    static constexpr std::size_t window_size = 1 << 16;
+
+    // BlockImpl に完全なレコードのみを見せる入力．位置は stream_ の読み進めていない部分の先頭からの相対位置である．
+    class Source
+    {
+    private:
+
+      AsyncInputStream<char_type>& stream_;
+
+    public:
+
+      // 見せている部分の長さ．
+      std::size_t exposed_;
+      // レコードの区切りを探し終えた部分の長さ．
+      std::size_t scanned_;
+
+      explicit Source(AsyncInputStream<char_type>& stream) noexcept:
+        stream_(stream), exposed_(0), scanned_(0)
+      {}
+
+      std::basic_string_view<char_type> peek_span() const noexcept
+      {
+        return stream_.peek_span().substr(0, exposed_);
+      }
+
+      void consume(std::size_t n) noexcept
+      {
+        assert(n <= exposed_);
+        stream_.consume(n);
+        exposed_ -= n;
+        scanned_ -= n;
+      }
+
+    };
+
+    using Impl = typename CSVParser<char_type>::template BlockImpl<Source&, RuntimeDialect<char_type>>;
+
+    AsyncInputStream<char_type> stream_;
+    CSVOptions<char_type> options_;
+    std::string encoding_;
+    Source source_;
+    Impl impl_;
+    std::unique_ptr<std::uint32_t[]> positions_;
+    bool in_quote_;
+    std::shared_ptr<const CSVHeader<char_type>> header_;
+
+    // 読み込んだ入力のうち，まだ探していない部分からレコードの区切りを探し，完全なレコードを source_ に見せる．
+    // 入力の終わりに達していれば，残りをすべて見せる．
+    void expose()
+    {
+      auto span = stream_.peek_span();
+      auto s = reinterpret_cast<const char*>(span.data());
+      auto exposed = source_.exposed_;
+      for(auto i = source_.scanned_; i < span.size(); i += window_size){
+        auto m = std::min(window_size, span.size() - i);
+        // note: 区切り文字に LF を指定すると，囲み文字の外側の LF（と囲み文字）の位置が得られる．
+        auto k = options_.quoting ? index_csv_structurals(s + i, m, '\n', static_cast<char>(options_.quote), in_quote_, positions_.get())
+                                  : index_csv_separators(s + i, m, '\n', positions_.get());
+        for(std::size_t j = k; j != 0; --j){
+          if(s[i + positions_[j - 1]] == '\n'){
+            exposed = i + positions_[j - 1] + 1;
+            break;
+          }
+        }
+      }
+      source_.scanned_ = span.size();
+      if(stream_.reached_eof()) exposed = span.size();
+      if(exposed != source_.exposed_){
+        validate_encoding(s + source_.exposed_, exposed - source_.exposed_, encoding_);
+        source_.exposed_ = exposed;
+        impl_.refresh();
+      }
+    }
+
+    // 完全なレコードが増えるか入力の終わりに達するまで読み込む．読むべきレコードがなくなった場合は false を返す．
+    Task<bool> fill()
+    {
+      while(impl_.eof()){
+        if(stream_.reached_eof()) co_return false;
+        co_await stream_.refill();
+        expose();
+      }
+      co_return true;
+    }
+
+  public:
+
+    AsyncCSVParser(AsyncInputStream<char_type>&& stream, const CSVOptions<char_type>& options = {}, const std::string& encoding = "utf-8"):
+      stream_(std::move(stream)), options_(options), encoding_(encoding), source_(stream_), impl_(source_, options_),
+      positions_(std::make_unique<std::uint32_t[]>(window_size + index_padding)), in_quote_(false), header_()
+    {}
+
+    /// レコードを先頭から順に生成する AsyncGenerator を返す．1 つの AsyncCSVParser につき 1 回だけ呼べる．
+    /// レコードは CSVParser と同様に，次のレコードを読むまで有効である．
+    AsyncGenerator<Record> records()
+    {
+      // note: ヘッダや列の名前の解決には先頭のレコードが必要なので，先に読み込んでおく．
+      co_await fill();
+      header_ = CSVParser<char_type>::select_columns(impl_, options_);
+      // note: GCC 12 は while の条件式の中の co_await を正しく扱えないので，本体の中で待つ．
+      while(true){
+        if(impl_.eof()){
+          bool more = co_await fill();
+          if(!more) break;
+        }
+        impl_.next();
+        co_yield impl_.get();
+      }
+    }
+
+    /// ヘッダを読み込んだ場合（CSVOptions::header）はその表を，そうでなければ nullptr を返す．records() で最初のレコードを受け取った後に有効となる．
+    const CSVHeader<char_type>* header() const noexcept
+    {
+      return header_.get();
+    }
+
+    /// name という名前の列を返す．
+    ColumnRef column(std::basic_string_view<char_type> name) const
+    {
+      if(header_ == nullptr) throw std::runtime_error("no header.");
+      return header_->column(name);
+    }
+
+  // deleted:
+
+    AsyncCSVParser() = delete;
+    AsyncCSVParser(AsyncCSVParser&&) = delete;
+    AsyncCSVParser(const AsyncCSVParser&) = delete;
+    AsyncCSVParser& operator=(AsyncCSVParser&&) = delete;
+    AsyncCSVParser& operator=(const AsyncCSVParser&) = delete;
+
+  };
+
+}
+
+
+#endif
+
+
+#endif
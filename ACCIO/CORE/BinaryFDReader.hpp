@@ -0,0 +1,326 @@
+#ifndef ACCIO_CORE_BINARYFDREADER_HPP_
+#define ACCIO_CORE_BINARYFDREADER_HPP_
+
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "Reader.hpp"
+#include "Statistics.hpp"
+
+
+namespace ACCIO::CORE
+{
+
+  class BinaryFDReader: public BinaryReader
+  {
+  protected:
+
+    static constexpr std::size_t default_min_buffer_size = 1024;
+    // note: パイプ等のファイル以外では，一度に読める大きさはパイプのバッファの大きさ程度である．
+    static constexpr std::size_t default_preferred_buffer_size = 1 << 16;
+    static constexpr std::size_t max_preferred_buffer_size = 1 << 20;
+
+    int fd_;
+
+  public:
+
+    explicit BinaryFDReader(int fd):
+      fd_(fd)
+    {}
+
+    std::size_t min_buffer_size() const noexcept override
+    {
+      if(fd_ < 0) return 0;
+      struct stat st;
+      auto ret = ::fstat(fd_, &st);
+      if(ret == 0 && st.st_blksize > 0){
+        // default_min_buffer_size を st.st_blksize の倍数に切り上げる．
+        return ((default_min_buffer_size - 1) / static_cast<std::size_t>(st.st_blksize) + 1) * static_cast<std::size_t>(st.st_blksize);
+      }else{
+        // note: fstat のエラーは無視する．
+        return default_min_buffer_size;
+      }
+    }
+
+    /// 通常のファイルではファイル全体（ただし max_preferred_buffer_size まで）を，それ以外では default_preferred_buffer_size を，
+    /// st.st_blksize の倍数に切り上げて返す．
+    std::size_t preferred_buffer_size() const noexcept override
+    {
+      if(fd_ < 0) return 0;
+      struct stat st;
+      if(::fstat(fd_, &st) != 0) return default_preferred_buffer_size;
+      auto block_size = st.st_blksize > 0 ? static_cast<std::size_t>(st.st_blksize) : default_min_buffer_size;
+      auto size = S_ISREG(st.st_mode) ? std::min(static_cast<std::size_t>(st.st_size), max_preferred_buffer_size) : default_preferred_buffer_size;
+      return std::max((size + block_size - 1) / block_size * block_size, min_buffer_size());
+    }
+
+    std::size_t operator()(char* buffer, std::size_t limit) override
+    {
+      if(fd_ < 0) return 0;
+      // limit を default_min_buffer_size の倍数に切り下げる．
+      limit = limit / default_min_buffer_size * default_min_buffer_size;
+      auto result = ::read(fd_, buffer, limit);
+      if(result < 0) throw std::runtime_error("read() failure.");
+      ACCIO_STATISTICS_ADD(read_calls, 1);
+      ACCIO_STATISTICS_ADD(bytes_read, result);
+      return result;
+    }
+
+    void close() noexcept override
+    {
+      // 何もしない．
+    }
+
+  };
+
+
+  class BinaryFileReader final: public BinaryFDReader
+  {
+  private:
+
+    static int open(const std::string& path)
+    {
+      int fd = ::open(path.c_str(), O_RDONLY);
+      if(fd < 0) throw std::runtime_error("Cannot open \"" + path + "\".");
+      return fd;
+    }
+
+  public:
+
+    explicit BinaryFileReader(const std::string& path):
+      BinaryFDReader(open(path))
+    {}
+
+    /// 既に開かれているファイル記述子 fd の所有権を引き取る．
+    explicit BinaryFileReader(int fd):
+      BinaryFDReader(fd)
+    {}
+
+    BinaryFileReader(BinaryFileReader&& other) = default;
+
+    ~BinaryFileReader() noexcept
+    {
+      close();
+    }
+
+    void close() noexcept override
+    {
+      if(fd_ >= 0){
+        auto ret = ::close(fd_);
+        // note: close のエラーはデバッグ時のみ捕捉する．
+        assert(ret == 0); static_cast<void>(ret);
+        fd_ = -1;
+      }
+    }
+
+  };
+
+
+  /// ファイルの [first, last) の範囲のみを pread() で読み込む．
+  class BinaryFileRangeReader final: public BinaryFDReader
+  {
+  private:
+
+    std::uint64_t position_;
+    std::uint64_t last_;
+
+  public:
+
+    BinaryFileRangeReader(const std::string& path, std::uint64_t first, std::uint64_t last):
+      BinaryFDReader(::open(path.c_str(), O_RDONLY)), position_(first), last_(last)
+    {
+      if(fd_ < 0) throw std::runtime_error("Cannot open \"" + path + "\".");
+    }
+
+    /// 既に開かれているファイル記述子 fd の所有権を引き取る．
+    BinaryFileRangeReader(int fd, std::uint64_t first, std::uint64_t last):
+      BinaryFDReader(fd), position_(first), last_(last)
+    {}
+
+    ~BinaryFileRangeReader() noexcept
+    {
+      close();
+    }
+
+    std::size_t preferred_buffer_size() const noexcept override
+    {
+      auto rest = position_ < last_ ? last_ - position_ : 0;
+      return std::max<std::size_t>(std::min<std::uint64_t>(BinaryFDReader::preferred_buffer_size(), rest), min_buffer_size());
+    }
+
+    std::size_t operator()(char* buffer, std::size_t limit) override
+    {
+      if(fd_ < 0 || position_ >= last_) return 0;
+      auto result = ::pread(fd_, buffer, static_cast<std::size_t>(std::min<std::uint64_t>(limit, last_ - position_)), static_cast<off_t>(position_));
+      if(result < 0) throw std::runtime_error("read() failure.");
+      ACCIO_STATISTICS_ADD(read_calls, 1);
+      ACCIO_STATISTICS_ADD(bytes_read, result);
+      position_ += static_cast<std::uint64_t>(result);
+      return static_cast<std::size_t>(result);
+    }
+
+    void close() noexcept override
+    {
+      if(fd_ >= 0){
+        auto ret = ::close(fd_);
+        assert(ret == 0); static_cast<void>(ret);
+        fd_ = -1;
+      }
+    }
+
+  // deleted:
+
+    BinaryFileRangeReader(BinaryFileRangeReader&&) = delete;
+    BinaryFileRangeReader(const BinaryFileRangeReader&) = delete;
+    BinaryFileRangeReader& operator=(BinaryFileRangeReader&&) = delete;
+    BinaryFileRangeReader& operator=(const BinaryFileRangeReader&) = delete;
+
+  };
+
+
+  class BinaryMappedFileReader final: public BinaryReader
+  {
+  private:
+
+    // note: map() で一度に返す領域の大きさ．InputStream のバッファサイズとしても使われる．
+    static constexpr std::size_t default_chunk_size = 1 << 20;
+
+    int fd_;
+    char* first_;
+    std::size_t size_;
+    std::size_t position_;
+    // 読み込む範囲の末尾．
+    std::size_t last_;
+
+    // 先頭から size_ バイトをマップする．size_ が 0 の場合は何もしない．
+    void map_file()
+    {
+      if(size_ == 0) return;
+      void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+      if(p == MAP_FAILED) throw std::runtime_error("mmap() failure.");
+      first_ = static_cast<char*>(p);
+      // note: madvise はヒントに過ぎないので，エラーは無視する．
+      ::madvise(first_, size_, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+      ::madvise(first_, size_, MADV_HUGEPAGE);
+#endif
+    }
+
+  public:
+
+    /// fd の所有権を引き取り，先頭から size バイトをマップする．失敗した場合は fd を閉じずに例外を送出する．
+    BinaryMappedFileReader(int fd, std::size_t size):
+      fd_(fd), first_(nullptr), size_(size), position_(0), last_(size)
+    {
+      map_file();
+    }
+
+    /// file_path のファイル全体をマップする．通常のファイルでない場合やマップに失敗した場合は例外を送出する．
+    explicit BinaryMappedFileReader(const std::string& file_path):
+      fd_(::open(file_path.c_str(), O_RDONLY)), first_(nullptr), size_(0), position_(0), last_(0)
+    {
+      if(fd_ < 0) throw std::runtime_error("Cannot open \"" + file_path + "\".");
+      struct stat st;
+      if(::fstat(fd_, &st) != 0 || !S_ISREG(st.st_mode)){
+        close();
+        throw std::runtime_error("mmap() failure.");
+      }
+      size_ = last_ = static_cast<std::size_t>(st.st_size);
+      try{
+        map_file();
+      }catch(...){
+        close();
+        throw;
+      }
+    }
+
+    ~BinaryMappedFileReader() noexcept
+    {
+      close();
+    }
+
+    /// 以降に読み込む範囲をファイルの [first, last) とする（ファイルの末尾を越える部分は無視する）．
+    void set_range(std::size_t first, std::size_t last) noexcept
+    {
+      last_ = std::min(last, size_);
+      position_ = std::min(first, last_);
+    }
+
+    // note: map() はどの大きさでも領域を返せるので，MappedInputMode 等で指定した小さなバッファの大きさも受け付ける．
+    std::size_t min_buffer_size() const noexcept override
+    {
+      return 1;
+    }
+
+    std::size_t preferred_buffer_size() const noexcept override
+    {
+      return default_chunk_size;
+    }
+
+    std::size_t operator()(char* buffer, std::size_t limit) override
+    {
+      auto [first, n] = map(limit);
+      std::memcpy(buffer, first, n);
+      return n;
+    }
+
+    bool mappable() const noexcept override
+    {
+      return true;
+    }
+
+    std::tuple<const char*, std::size_t> map(std::size_t limit) override
+    {
+      if(first_ == nullptr) return {nullptr, 0};
+      auto n = std::min(limit, last_ - position_);
+      const char* result = first_ + position_;
+      position_ += n;
+      ACCIO_STATISTICS_ADD(map_calls, 1);
+      ACCIO_STATISTICS_ADD(bytes_mapped, n);
+      // 次に返す領域の先読みを促す．
+      if(position_ < last_){
+        auto page_size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        auto ahead = position_ / page_size * page_size;
+        ::madvise(first_ + ahead, std::min(limit, last_ - ahead), MADV_WILLNEED);
+      }
+      return {result, n};
+    }
+
+    void close() noexcept override
+    {
+      if(first_ != nullptr){
+        auto ret = ::munmap(first_, size_);
+        // note: munmap のエラーはデバッグ時のみ捕捉する．
+        assert(ret == 0); static_cast<void>(ret);
+        first_ = nullptr;
+        size_ = 0;
+        position_ = 0;
+        last_ = 0;
+      }
+      if(fd_ >= 0){
+        auto ret = ::close(fd_);
+        assert(ret == 0); static_cast<void>(ret);
+        fd_ = -1;
+      }
+    }
+
+  // deleted:
+
+    BinaryMappedFileReader(BinaryMappedFileReader&&) = delete;
+    BinaryMappedFileReader(const BinaryMappedFileReader&) = delete;
+    BinaryMappedFileReader& operator=(BinaryMappedFileReader&&) = delete;
+    BinaryMappedFileReader& operator=(const BinaryMappedFileReader&) = delete;
+
+  };
+
+}
+
+
+#endif
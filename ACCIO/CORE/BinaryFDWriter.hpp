@@ -0,0 +1,104 @@
+#ifndef ACCIO_CORE_BINARYFDWRITER_HPP_
+#define ACCIO_CORE_BINARYFDWRITER_HPP_
+
+
+#include <cassert>
+#include <cerrno>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "Writer.hpp"
+
+
+namespace ACCIO::CORE
+{
+
+  class BinaryFDWriter: public BinaryWriter
+  {
+  protected:
+
+    static constexpr std::size_t default_buffer_size = 1 << 20;
+
+    int fd_;
+
+  public:
+
+    explicit BinaryFDWriter(int fd):
+      fd_(fd)
+    {}
+
+    std::size_t preferred_buffer_size() const noexcept override
+    {
+      return default_buffer_size;
+    }
+
+    void operator()(const char* data, std::size_t n) override
+    {
+      if(fd_ < 0) throw std::runtime_error("write() failure.");
+      // note: パイプ等では一度にすべてを書き込めないことがある．
+      while(n > 0){
+        auto result = ::write(fd_, data, n);
+        if(result < 0){
+          if(errno == EINTR) continue;
+          throw std::runtime_error("write() failure.");
+        }
+        data += result;
+        n -= static_cast<std::size_t>(result);
+      }
+    }
+
+    void close() noexcept override
+    {
+      // 何もしない．
+    }
+
+  };
+
+
+  class BinaryFileWriter final: public BinaryFDWriter
+  {
+  private:
+
+    static int open(const std::string& path)
+    {
+      int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+      if(fd < 0) throw std::runtime_error("Cannot open \"" + path + "\".");
+      return fd;
+    }
+
+  public:
+
+    explicit BinaryFileWriter(const std::string& path):
+      BinaryFDWriter(open(path))
+    {}
+
+    ~BinaryFileWriter() noexcept
+    {
+      close();
+    }
+
+    void close() noexcept override
+    {
+      if(fd_ >= 0){
+        auto ret = ::close(fd_);
+        // note: close のエラーはデバッグ時のみ捕捉する．
+        assert(ret == 0); static_cast<void>(ret);
+        fd_ = -1;
+      }
+    }
+
+  // deleted:
+
+    BinaryFileWriter(BinaryFileWriter&&) = delete;
+    BinaryFileWriter(const BinaryFileWriter&) = delete;
+    BinaryFileWriter& operator=(BinaryFileWriter&&) = delete;
+    BinaryFileWriter& operator=(const BinaryFileWriter&) = delete;
+
+  };
+
+}
+
+
+#endif
@@ -1,105 +1,61 @@
-#include <algorithm>
-#include <cassert>
 #include <fcntl.h>
+#include <stdexcept>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include "BinaryFDReader.hpp"
 #include "BinaryFileReader.hpp"
 
 
 namespace ACCIO::CORE
 {
 
-  class BinaryFDReader: public BinaryReader
+  std::unique_ptr<BinaryReader> make_binary_fd_reader(int file_descriptor)
   {
-  protected:
-
-    static constexpr std::size_t default_min_buffer_size = 1024;
-
-    int fd_;
-
-  public:
-
-    explicit BinaryFDReader(int fd):
-      fd_(fd)
-    {}
-
-    std::size_t min_buffer_size() const noexcept override
-    {
-      if(fd_ < 0) return 0;
-      struct stat st;
-      auto ret = ::fstat(fd_, &st);
-      if(ret == 0 && st.st_blksize > 0){
-        // default_min_buffer_size を st.st_blksize の倍数に切り上げる．
-        return ((default_min_buffer_size - 1) / static_cast<std::size_t>(st.st_blksize) + 1) * static_cast<std::size_t>(st.st_blksize);
-      }else{
-        // note: fstat のエラーは無視する．
-        return default_min_buffer_size;
-      }
-    }
-
-    std::size_t operator()(char* buffer, std::size_t limit) override
-    {
-      if(fd_ < 0) return 0;
-      // limit を default_min_buffer_size の倍数に切り下げる．
-      limit = limit / default_min_buffer_size * default_min_buffer_size;
-      auto result = ::read(fd_, buffer, limit);
-      if(result < 0) throw std::runtime_error("read() failure.");
-      return result;
-    }
-
-    void close() noexcept override
-    {
-      // 何もしない．
-    }
-
-  };
-
+    return std::make_unique<BinaryFDReader>(file_descriptor);
+  }
 
-  class BinaryFileReader: public BinaryFDReader
+  std::unique_ptr<BinaryReader> make_binary_file_reader(const std::string& file_path)
   {
-  private:
-
-    static int open(const std::string& path)
-    {
-      int fd = ::open(path.c_str(), O_RDONLY);
-      if(fd < 0) throw std::runtime_error("Cannot open \"" + path + "\".");
-      return fd;
-    }
-
-  public:
-
-    explicit BinaryFileReader(const std::string& path):
-      BinaryFDReader(open(path))
-    {}
-
-    BinaryFileReader(BinaryFileReader&& other) = default;
-
-    ~BinaryFileReader() noexcept
-    {
-      close();
-    }
+    return std::make_unique<BinaryFileReader>(file_path);
+  }
 
-    void close() noexcept override
-    {
-      if(fd_ >= 0){
-        auto ret = ::close(fd_);
-        // note: close のエラーはデバッグ時のみ捕捉する．
-        assert(ret == 0); static_cast<void>(ret);
-        fd_ = -1;
+  std::unique_ptr<BinaryReader> make_binary_mmap_reader(const std::string& file_path)
+  {
+    int fd = ::open(file_path.c_str(), O_RDONLY);
+    if(fd < 0) throw std::runtime_error("Cannot open \"" + file_path + "\".");
+    struct stat st;
+    // note: 通常のファイル以外（パイプ等）や空のファイルはマップできないので，read() による読み込みにフォールバックする．
+    if(::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0){
+      try{
+        return std::make_unique<BinaryMappedFileReader>(fd, static_cast<std::size_t>(st.st_size));
+      }catch(const std::runtime_error&){
+        // mmap() に失敗した場合もフォールバックする．
       }
     }
+    return std::make_unique<BinaryFileReader>(fd);
+  }
 
-  };
-
-  std::unique_ptr<BinaryReader> make_binary_fd_reader(int file_descriptor)
+  std::unique_ptr<BinaryReader> make_binary_file_reader(const std::string& file_path, std::uint64_t first, std::uint64_t last)
   {
-    return std::make_unique<BinaryFDReader>(file_descriptor);
+    return std::make_unique<BinaryFileRangeReader>(file_path, first, last);
   }
 
-  std::unique_ptr<BinaryReader> make_binary_file_reader(const std::string& file_path)
+  std::unique_ptr<BinaryReader> make_binary_mmap_reader(const std::string& file_path, std::uint64_t first, std::uint64_t last)
   {
-    return std::make_unique<BinaryFileReader>(file_path);
+    int fd = ::open(file_path.c_str(), O_RDONLY);
+    if(fd < 0) throw std::runtime_error("Cannot open \"" + file_path + "\".");
+    struct stat st;
+    if(::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0){
+      try{
+        auto reader = std::make_unique<BinaryMappedFileReader>(fd, static_cast<std::size_t>(st.st_size));
+        reader->set_range(static_cast<std::size_t>(first), static_cast<std::size_t>(last));
+        return reader;
+      }catch(const std::runtime_error&){
+        // mmap() に失敗した場合は pread() による読み込みにフォールバックする．
+      }
+    }
+    return std::make_unique<BinaryFileRangeReader>(fd, first, last);
   }
 
   std::unique_ptr<BinaryReader> make_binary_stdin_reader()
@@ -107,4 +63,12 @@ namespace ACCIO::CORE
     return make_binary_fd_reader(0);
   }
 
+  void prefetch_file(const std::string& file_path, std::uint64_t size) noexcept
+  {
+    int fd = ::open(file_path.c_str(), O_RDONLY);
+    if(fd < 0) return;
+    ::posix_fadvise(fd, 0, static_cast<off_t>(size), POSIX_FADV_WILLNEED);
+    ::close(fd);
+  }
+
 }
@@ -12,8 +12,22 @@ namespace ACCIO::CORE
 
   std::unique_ptr<BinaryReader> make_binary_file_reader(const std::string& file_path);
 
+  /// ファイルをメモリにマップして読み込む BinaryReader を作成する．マップできない場合は make_binary_file_reader と同様に振る舞う．
+  /// マップした場合の map() は limit の範囲でファイルの残りを返し，返された領域は reader を閉じるまで有効である．
+  std::unique_ptr<BinaryReader> make_binary_mmap_reader(const std::string& file_path);
+
+  /// ファイルの [first, last) の範囲のみを読み込む BinaryReader を作成する（ファイルの末尾を越える部分は無視する）．
+  std::unique_ptr<BinaryReader> make_binary_file_reader(const std::string& file_path, std::uint64_t first, std::uint64_t last);
+
+  /// make_binary_mmap_reader と同様に，ファイルの [first, last) の範囲のみを読み込む BinaryReader を作成する．
+  std::unique_ptr<BinaryReader> make_binary_mmap_reader(const std::string& file_path, std::uint64_t first, std::uint64_t last);
+
   std::unique_ptr<BinaryReader> make_binary_stdin_reader();
 
+  /// file_path のファイルの先頭 size バイトの先読みをカーネルに促す（読み込みの完了は待たない）．
+  /// note: ヒントに過ぎないので，ファイルを開けない場合などのエラーは無視する．
+  void prefetch_file(const std::string& file_path, std::uint64_t size) noexcept;
+
 }
 
 
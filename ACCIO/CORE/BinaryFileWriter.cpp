@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <cassert>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "BinaryFDWriter.hpp"
+#include "BinaryFileWriter.hpp"
+
+
+namespace ACCIO::CORE
+{
+
+  class BinaryBackgroundWriter final: public BinaryWriter
+  {
+  private:
+
+    struct Slot
+    {
+      AlignedArray<char> buffer_;
+      std::size_t capacity_;
+      std::size_t size_;
+    };
+
+    std::unique_ptr<BinaryWriter> binary_writer_;
+    std::size_t buffer_size_;
+    std::vector<Slot> slots_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    // 書き込みスレッドが次に書き込むスロットと，利用側が次に埋めるスロット．
+    std::size_t read_index_;
+    std::size_t write_index_;
+    // 書き込みを待っているスロットの数．
+    std::size_t filled_;
+    bool stop_;
+    std::exception_ptr exception_;
+    std::thread thread_;
+
+    void run() noexcept
+    {
+      while(true){
+        std::size_t index;
+        {
+          std::unique_lock<std::mutex> lock(mutex_);
+          condition_.wait(lock, [this]{ return stop_ || filled_ > 0; });
+          if(filled_ == 0) return;
+          index = read_index_;
+        }
+        // note: slots_[index] は filled_ に数えられている間は利用側から参照されないので，ロックせずに読み出せる．
+        try{
+          (*binary_writer_)(slots_[index].buffer_.get(), slots_[index].size_);
+        }catch(...){
+          std::lock_guard<std::mutex> lock(mutex_);
+          exception_ = std::current_exception();
+          condition_.notify_all();
+          return;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        slots_[index].size_ = 0;
+        read_index_ = (read_index_ + 1) % slots_.size();
+        --filled_;
+        condition_.notify_all();
+      }
+    }
+
+    void rethrow()
+    {
+      if(exception_ != nullptr) std::rethrow_exception(exception_);
+    }
+
+    // 利用側が埋めたスロットを書き込みスレッドに渡し，次に埋めるスロットが空くまで待つ．
+    void advance(std::unique_lock<std::mutex>& lock)
+    {
+      write_index_ = (write_index_ + 1) % slots_.size();
+      ++filled_;
+      condition_.notify_all();
+      condition_.wait(lock, [this]{ return filled_ < slots_.size() || exception_ != nullptr; });
+    }
+
+    // 利用側が埋めているスロットを書き込みスレッドに渡す．
+    void submit()
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      rethrow();
+      if(slots_[write_index_].size_ == 0) return;
+      advance(lock);
+      rethrow();
+    }
+
+  public:
+
+    BinaryBackgroundWriter(std::unique_ptr<BinaryWriter>&& binary_writer, std::size_t buffer_size, std::size_t depth):
+      binary_writer_(std::move(binary_writer)), buffer_size_(std::max<std::size_t>(buffer_size, 1)), slots_(std::max<std::size_t>(depth, 2)),
+      mutex_(), condition_(), read_index_(0), write_index_(0), filled_(0), stop_(false), exception_(), thread_()
+    {
+      for(auto&& slot: slots_){
+        slot.buffer_ = make_aligned_array<char>(buffer_size_);
+        slot.capacity_ = buffer_size_;
+        slot.size_ = 0;
+      }
+      thread_ = std::thread([this]{ run(); });
+    }
+
+    ~BinaryBackgroundWriter() noexcept
+    {
+      close();
+    }
+
+    std::size_t preferred_buffer_size() const noexcept override
+    {
+      return buffer_size_;
+    }
+
+    void operator()(const char* data, std::size_t n) override
+    {
+      while(n > 0){
+        auto& slot = slots_[write_index_];
+        auto m = std::min(n, slot.capacity_ - slot.size_);
+        std::memcpy(slot.buffer_.get() + slot.size_, data, m);
+        slot.size_ += m;
+        data += m;
+        n -= m;
+        if(slot.size_ == slot.capacity_){
+          submit();
+        }
+      }
+    }
+
+    bool swappable() const noexcept override
+    {
+      return true;
+    }
+
+    void swap_buffer(AlignedArray<char>& buffer, std::size_t capacity, std::size_t n) override
+    {
+      assert(n <= capacity);
+      // operator() で埋めかけたスロットがあれば，順序を保つために先に渡す．
+      submit();
+      auto& slot = slots_[write_index_];
+      if(slot.capacity_ < capacity){
+        slot.buffer_ = make_aligned_array<char>(capacity);
+        slot.capacity_ = capacity;
+      }
+      // note: 次に埋めるスロットは書き込み終えているので，そのバッファを返す．
+      std::swap(slot.buffer_, buffer);
+      slot.capacity_ = capacity;
+      slot.size_ = n;
+      // note: ここで書き込みのエラーを報告すると buffer を交換した後になるので，エラーは次の呼び出しか flush() で報告する．
+      std::unique_lock<std::mutex> lock(mutex_);
+      advance(lock);
+    }
+
+    void flush() override
+    {
+      submit();
+      std::unique_lock<std::mutex> lock(mutex_);
+      condition_.wait(lock, [this]{ return filled_ == 0 || exception_ != nullptr; });
+      rethrow();
+      lock.unlock();
+      binary_writer_->flush();
+    }
+
+    /// note: 書き込みのエラーは flush() でのみ報告される．close() の前に flush() を呼ぶこと．
+    void close() noexcept override
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+        condition_.notify_all();
+      }
+      if(thread_.joinable()){
+        // note: 書き込みスレッドは渡されたスロットを書き込み終えてから終了する．
+        thread_.join();
+      }
+      if(binary_writer_ != nullptr){
+        binary_writer_->close();
+        binary_writer_ = nullptr;
+      }
+    }
+
+  // deleted:
+
+    BinaryBackgroundWriter(BinaryBackgroundWriter&&) = delete;
+    BinaryBackgroundWriter(const BinaryBackgroundWriter&) = delete;
+    BinaryBackgroundWriter& operator=(BinaryBackgroundWriter&&) = delete;
+    BinaryBackgroundWriter& operator=(const BinaryBackgroundWriter&) = delete;
+
+  };
+
+  std::unique_ptr<BinaryWriter> make_binary_fd_writer(int file_descriptor)
+  {
+    return std::make_unique<BinaryFDWriter>(file_descriptor);
+  }
+
+  std::unique_ptr<BinaryWriter> make_binary_file_writer(const std::string& file_path)
+  {
+    return std::make_unique<BinaryFileWriter>(file_path);
+  }
+
+  std::unique_ptr<BinaryWriter> make_binary_stdout_writer()
+  {
+    return make_binary_fd_writer(1);
+  }
+
+  std::unique_ptr<BinaryWriter> make_binary_background_writer(std::unique_ptr<BinaryWriter>&& binary_writer, std::size_t buffer_size, std::size_t depth)
+  {
+    return std::make_unique<BinaryBackgroundWriter>(std::move(binary_writer), buffer_size, depth);
+  }
+
+}
@@ -0,0 +1,25 @@
+#ifndef ACCIO_CORE_BINARYFILEWRITER_HPP_
+#define ACCIO_CORE_BINARYFILEWRITER_HPP_
+
+
+#include "Writer.hpp"
+
+
+namespace ACCIO::CORE
+{
+
+  std::unique_ptr<BinaryWriter> make_binary_fd_writer(int file_descriptor);
+
+  /// file_path を作成（既にある場合は空に）して書き込む BinaryWriter を作成する．
+  std::unique_ptr<BinaryWriter> make_binary_file_writer(const std::string& file_path);
+
+  std::unique_ptr<BinaryWriter> make_binary_stdout_writer();
+
+  /// binary_writer への書き込みを別スレッドで行う BinaryWriter を作成する．
+  /// buffer_size バイトのバッファを depth 個（2 以上）用意し，1 つを書き込んでいる間に残りに書き込み内容を溜める．
+  std::unique_ptr<BinaryWriter> make_binary_background_writer(std::unique_ptr<BinaryWriter>&& binary_writer, std::size_t buffer_size, std::size_t depth);
+
+}
+
+
+#endif
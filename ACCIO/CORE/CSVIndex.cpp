@@ -0,0 +1,247 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "BinaryFileReader.hpp"
+#include "BinaryFileWriter.hpp"
+#include "CSVIndex.hpp"
+#include "SIMD.hpp"
+
+
+namespace ACCIO::CORE
+{
+
+  namespace
+  {
+
+    // 索引ファイルの形式．数値はすべてこの環境のバイト順で書き込む．
+    //   magic[8], version (u32), flags (u32, bit 0: quoting), quote (u64),
+    //   stride, records, file_size (u64), file_mtime (i64), オフセットの個数 (u64), オフセット (u64 × 個数)
+    constexpr char magic[8] = {'A', 'C', 'C', 'I', 'O', 'I', 'D', 'X'};
+    constexpr std::uint32_t version = 1;
+    constexpr std::size_t header_size = 8 + 4 + 4 + 8 + 8 * 5;
+
+    constexpr std::size_t window_size = 1 << 16;
+
+    struct FileStatus
+    {
+      std::uint64_t size_;
+      std::int64_t mtime_;
+    };
+
+    FileStatus file_status(const std::string& file_path)
+    {
+      struct stat st;
+      if(::stat(file_path.c_str(), &st) != 0) throw std::runtime_error("Cannot open \"" + file_path + "\".");
+      return {static_cast<std::uint64_t>(st.st_size), static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec};
+    }
+
+    template<class T>
+    void put(std::string& out, T value)
+    {
+      out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    template<class T>
+    T get(const std::string& in, std::size_t& position)
+    {
+      T value;
+      std::memcpy(&value, in.data() + position, sizeof(value));
+      position += sizeof(value);
+      return value;
+    }
+
+    // 入力を先頭から順に受け取り，囲み文字の外側の LF を数えながら stride 個ごとのレコードの位置を記録する．
+    class Builder
+    {
+    private:
+
+      CSVIndexOptions options_;
+      std::unique_ptr<std::uint32_t[]> positions_;
+      std::vector<std::uint64_t> offsets_;
+      std::uint64_t line_feeds_;
+      std::uint64_t position_;
+      bool in_quote_;
+      // 最後に受け取ったバイトが囲み文字の外側の LF であるか．
+      bool ended_;
+
+    public:
+
+      explicit Builder(const CSVIndexOptions& options):
+        options_(options), positions_(std::make_unique<std::uint32_t[]>(window_size + index_padding)), offsets_{0},
+        line_feeds_(0), position_(0), in_quote_(false), ended_(false)
+      {
+        if(options_.stride == 0) throw std::runtime_error("invalid stride.");
+      }
+
+      void feed(const char* s, std::size_t n)
+      {
+        for(std::size_t i = 0; i < n; i += window_size){
+          auto m = std::min(window_size, n - i);
+          // note: 区切り文字に LF を指定すると，囲み文字の外側の LF（と囲み文字）の位置が得られる．
+          auto k = options_.quoting ? index_csv_structurals(s + i, m, '\n', options_.quote, in_quote_, positions_.get())
+                                    : index_csv_separators(s + i, m, '\n', positions_.get());
+          for(std::size_t j = 0; j < k; ++j){
+            if(s[i + positions_[j]] == '\n' && ++line_feeds_ % options_.stride == 0){
+              offsets_.push_back(position_ + i + positions_[j] + 1);
+            }
+          }
+          ended_ = k != 0 && positions_[k - 1] == m - 1 && s[i + m - 1] == '\n';
+        }
+        position_ += n;
+      }
+
+      CSVIndex finish(std::int64_t file_mtime)
+      {
+        if(in_quote_) throw std::runtime_error("unexpected EOF");
+        // note: 最後の LF の直後から始まるレコードはない．
+        if(offsets_.size() > 1 && offsets_.back() == position_){
+          offsets_.pop_back();
+        }
+        auto records = line_feeds_ + (position_ != 0 && !ended_ ? 1 : 0);
+        return CSVIndex(options_, records, position_, file_mtime, std::move(offsets_));
+      }
+
+    };
+
+  }
+
+  CSVIndex::CSVIndex(const CSVIndexOptions& options, std::uint64_t records, std::uint64_t file_size, std::int64_t file_mtime, std::vector<std::uint64_t>&& offsets):
+    options_(options), records_(records), file_size_(file_size), file_mtime_(file_mtime), offsets_(std::move(offsets))
+  {
+    if(options_.stride == 0 || offsets_.empty() || offsets_.size() != std::max<std::uint64_t>(1, (records_ + options_.stride - 1) / options_.stride)){
+      throw std::runtime_error("invalid index.");
+    }
+  }
+
+  std::pair<std::uint64_t, std::uint64_t> CSVIndex::locate(std::uint64_t record) const noexcept
+  {
+    if(record >= records_) return {file_size_, 0};
+    return {offsets_[record / options_.stride], record % options_.stride};
+  }
+
+  std::vector<std::pair<std::uint64_t, std::uint64_t>> CSVIndex::partition(std::size_t parts) const
+  {
+    parts = std::max<std::size_t>(parts, 1);
+    std::vector<std::uint64_t> bounds{0};
+    for(std::size_t i = 1; i < parts; ++i){
+      auto target = static_cast<std::uint64_t>(static_cast<unsigned __int128>(file_size_) * i / parts);
+      auto it = std::lower_bound(offsets_.begin(), offsets_.end(), target);
+      if(it != offsets_.end() && *it > bounds.back() && *it < file_size_){
+        bounds.push_back(*it);
+      }
+    }
+    bounds.push_back(file_size_);
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> result;
+    for(std::size_t i = 0; i + 1 < bounds.size(); ++i){
+      result.emplace_back(bounds[i], bounds[i + 1]);
+    }
+    return result;
+  }
+
+  void CSVIndex::save(const std::string& file_path) const
+  {
+    std::string out(magic, sizeof(magic));
+    put<std::uint32_t>(out, version);
+    put<std::uint32_t>(out, options_.quoting ? 1 : 0);
+    put<std::uint64_t>(out, static_cast<unsigned char>(options_.quote));
+    put<std::uint64_t>(out, options_.stride);
+    put<std::uint64_t>(out, records_);
+    put<std::uint64_t>(out, file_size_);
+    put<std::int64_t>(out, file_mtime_);
+    put<std::uint64_t>(out, offsets_.size());
+    out.append(reinterpret_cast<const char*>(offsets_.data()), offsets_.size() * sizeof(std::uint64_t));
+    auto writer = make_binary_file_writer(file_path);
+    (*writer)(out.data(), out.size());
+    writer->flush();
+    writer->close();
+  }
+
+  CSVIndex CSVIndex::load(const std::string& file_path)
+  {
+    auto reader = make_binary_file_reader(file_path);
+    std::string in;
+    auto buffer_size = std::max<std::size_t>(reader->preferred_buffer_size(), 1 << 16);
+    while(true){
+      auto offset = in.size();
+      in.resize(offset + buffer_size);
+      auto n = (*reader)(in.data() + offset, buffer_size);
+      in.resize(offset + n);
+      if(n == 0) break;
+    }
+    if(in.size() < header_size || std::memcmp(in.data(), magic, sizeof(magic)) != 0) throw std::runtime_error("invalid index file.");
+    std::size_t position = sizeof(magic);
+    if(get<std::uint32_t>(in, position) != version) throw std::runtime_error("invalid index file.");
+    CSVIndexOptions options;
+    options.quoting = (get<std::uint32_t>(in, position) & 1) != 0;
+    options.quote = static_cast<char>(get<std::uint64_t>(in, position));
+    options.stride = static_cast<std::size_t>(get<std::uint64_t>(in, position));
+    auto records = get<std::uint64_t>(in, position);
+    auto file_size = get<std::uint64_t>(in, position);
+    auto file_mtime = get<std::int64_t>(in, position);
+    auto count = get<std::uint64_t>(in, position);
+    if(count != (in.size() - header_size) / sizeof(std::uint64_t) || (in.size() - header_size) % sizeof(std::uint64_t) != 0){
+      throw std::runtime_error("invalid index file.");
+    }
+    std::vector<std::uint64_t> offsets(count);
+    std::memcpy(offsets.data(), in.data() + header_size, count * sizeof(std::uint64_t));
+    return CSVIndex(options, records, file_size, file_mtime, std::move(offsets));
+  }
+
+  // binary_reader の残りを読み込んで索引を作る．file_mtime は索引に記録するファイルの更新時刻．
+  static CSVIndex build(BinaryReader& binary_reader, const CSVIndexOptions& options, std::int64_t file_mtime)
+  {
+    Builder builder(options);
+    if(binary_reader.mappable()){
+      while(true){
+        auto [first, n] = binary_reader.map(std::max<std::size_t>(binary_reader.preferred_buffer_size(), window_size));
+        if(n == 0) break;
+        builder.feed(first, n);
+      }
+    }else{
+      auto buffer_size = std::max<std::size_t>(binary_reader.preferred_buffer_size(), window_size);
+      auto buffer = std::make_unique<char[]>(buffer_size);
+      while(true){
+        auto n = binary_reader(buffer.get(), buffer_size);
+        if(n == 0) break;
+        builder.feed(buffer.get(), n);
+      }
+    }
+    return builder.finish(file_mtime);
+  }
+
+  CSVIndex build_csv_index(BinaryReader& binary_reader, const CSVIndexOptions& options)
+  {
+    return build(binary_reader, options, 0);
+  }
+
+  CSVIndex build_csv_index(const std::string& file_path, const CSVIndexOptions& options)
+  {
+    auto status = file_status(file_path);
+    auto reader = make_binary_mmap_reader(file_path);
+    return build(*reader, options, status.mtime_);
+  }
+
+  CSVIndex load_csv_index(const std::string& file_path, const CSVIndexOptions& options)
+  {
+    auto status = file_status(file_path);
+    auto index_path = file_path + ".idx";
+    try{
+      auto index = CSVIndex::load(index_path);
+      if(index.file_size() == status.size_ && index.file_mtime() == status.mtime_ && index.stride() == options.stride &&
+         index.options().quoting == options.quoting && (!options.quoting || index.options().quote == options.quote)){
+        return index;
+      }
+    }catch(const std::runtime_error&){
+      // 索引ファイルがない，または壊れている場合は作り直す．
+    }
+    auto index = build_csv_index(file_path, options);
+    try{
+      index.save(index_path);
+    }catch(const std::runtime_error&){
+    }
+    return index;
+  }
+
+}
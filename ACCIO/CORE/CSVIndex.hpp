@@ -0,0 +1,114 @@
+#ifndef ACCIO_CORE_CSVINDEX_HPP_
+#define ACCIO_CORE_CSVINDEX_HPP_
+
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Reader.hpp"
+
+
+namespace ACCIO::CORE
+{
+
+  /// CSVIndex の作り方を指定する．
+  struct CSVIndexOptions
+  {
+    /// stride 個ごとのレコードの位置を記録する．
+    std::size_t stride = 1024;
+    /// フィールドを囲む文字（CSVOptions::quote と同じものを指定する）．
+    char quote = '\"';
+    /// false の場合は囲み文字を通常の文字として扱う（CSVOptions::quoting と同じものを指定する）．
+    bool quoting = true;
+  };
+
+  /// CSV ファイルのレコードの位置の索引．stride 個ごとのレコードの先頭のバイト位置を記録する．
+  /// レコードの区切りは CSVParser と同じく，囲み文字の外側の LF である．
+  /// note: バイト位置は読み込み元（デコード前）のものなので，ASCII と互換な文字コード（UTF-8 等）のファイルに用いる．
+  class CSVIndex
+  {
+  private:
+
+    CSVIndexOptions options_;
+    std::uint64_t records_;
+    std::uint64_t file_size_;
+    // 索引を作ったときのファイルの更新時刻（ナノ秒）．0 の場合は不明．
+    std::int64_t file_mtime_;
+    // offsets_[i] は i * stride 番目のレコードの先頭のバイト位置．
+    std::vector<std::uint64_t> offsets_;
+
+  public:
+
+    CSVIndex(const CSVIndexOptions& options, std::uint64_t records, std::uint64_t file_size, std::int64_t file_mtime, std::vector<std::uint64_t>&& offsets);
+
+    CSVIndex(CSVIndex&&) = default;
+    CSVIndex(const CSVIndex&) = default;
+    CSVIndex& operator=(CSVIndex&&) = default;
+    CSVIndex& operator=(const CSVIndex&) = default;
+
+    const CSVIndexOptions& options() const noexcept
+    {
+      return options_;
+    }
+
+    std::size_t stride() const noexcept
+    {
+      return options_.stride;
+    }
+
+    /// ファイルに含まれるレコードの数を返す．
+    std::uint64_t records() const noexcept
+    {
+      return records_;
+    }
+
+    std::uint64_t file_size() const noexcept
+    {
+      return file_size_;
+    }
+
+    std::int64_t file_mtime() const noexcept
+    {
+      return file_mtime_;
+    }
+
+    const std::vector<std::uint64_t>& offsets() const noexcept
+    {
+      return offsets_;
+    }
+
+    /// record 番目のレコードを読むために，読み始めるバイト位置と，そこから読み飛ばすレコードの数を返す．
+    /// record が records() 以上の場合はファイルの末尾を返す．
+    std::pair<std::uint64_t, std::uint64_t> locate(std::uint64_t record) const noexcept;
+
+    /// ファイルをレコードの境界で parts 個以下のバイト範囲 [first, last) に分ける．各範囲の先頭は記録したレコードの位置である．
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> partition(std::size_t parts) const;
+
+    /// 索引を file_path に書き込む．
+    void save(const std::string& file_path) const;
+
+    /// save() で書き込んだ索引を読み込む．
+    static CSVIndex load(const std::string& file_path);
+
+  // deleted:
+
+    CSVIndex() = delete;
+
+  };
+
+  /// binary_reader の残りを読み込んで索引を作る．
+  CSVIndex build_csv_index(BinaryReader& binary_reader, const CSVIndexOptions& options = {});
+
+  /// file_path のファイルの索引を作る．
+  CSVIndex build_csv_index(const std::string& file_path, const CSVIndexOptions& options = {});
+
+  /// file_path のファイルの索引を返す．索引ファイル（file_path + ".idx"）がファイルの大きさ・更新時刻・options と一致する場合はそれを読み込み，
+  /// そうでなければ索引を作って索引ファイルに書き込む．
+  /// note: 索引ファイルの書き込みに失敗した場合（書き込めないディレクトリ等）は，作った索引をそのまま返す．
+  CSVIndex load_csv_index(const std::string& file_path, const CSVIndexOptions& options = {});
+
+}
+
+
+#endif
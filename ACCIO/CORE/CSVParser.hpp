@@ -2,12 +2,22 @@
 #define ACCIO_CORE_CSVPARSER_HPP_
 
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
 #include <string_view>
 #include <stdexcept>
+#include <type_traits>
 #include <vector>
 #include "char8_t.hpp"
+#include "FieldConverter.hpp"
+#include "InputStream.hpp"
+#include "SIMD.hpp"
+#include "Statistics.hpp"
 
 
 namespace ACCIO::CORE
@@ -19,15 +29,185 @@ namespace ACCIO::CORE
   template<class charT>
   class CSVParser;
 
+  /// CSVParser の動作を指定する．
   template<class CharT>
+  struct CSVOptions
+  {
+    CharT delimiter = ',';
+    /// true の場合，可能なフィールドは入力のバッファを直接参照する（'\0' 終端されるとは限らない）．
+    /// フィールドは次のレコードを読むまで有効であり，CSVRecord をコピーした場合はコピー先が内容を保持する．
+    bool zero_copy = false;
+    /// 空でない場合は，指定した列のみをこの順に取り出す（重複は不可）．それ以外の列は構造のみを解析し，コピーも保持もしない．
+    /// 指定した列を持たないレコードでは，その要素は空となる．
+    std::vector<std::size_t> columns = {};
+    /// 空でない場合は，先頭のレコードをヘッダとして読み飛ばし，指定した名前の列のみをこの順に取り出す（重複は不可）．columns より優先する．
+    std::vector<std::basic_string<CharT>> column_names = {};
+    /// フィールドを囲む文字．
+    CharT quote = '\"';
+    /// false の場合は囲み文字を通常の文字として扱う（囲み文字を使わない TSV 等）．
+    bool quoting = true;
+    /// true の場合は CRLF の CR をフィールドに含めない．false の場合は CR を通常の文字として扱う．
+    bool crlf = true;
+    /// true の場合は囲み文字で囲まれていないフィールドの前後の空白（スペースとタブ）を取り除く．
+    /// note: 囲み文字で囲まれたフィールドの前後に空白を置くことはできない．
+    bool trim = false;
+    /// true の場合は先頭のレコードをヘッダとして読み込み，列の名前から位置を引く表（CSVHeader）を作る．
+    /// 以降のレコードは record["price"] や CSVParser::column() で得た ColumnRef で列を参照できる．
+    /// note: column_names または columns と併用した場合，表は取り出した列（この順）に対応する．
+    bool header = false;
+  };
+
+  /// CSVOptions で実行時に指定した方言．
+  template<class CharT>
+  class RuntimeDialect
+  {
+  private:
+
+    CharT delimiter_;
+    CharT quote_;
+    bool quoting_;
+    bool crlf_;
+    bool trim_;
+
+  public:
+
+    explicit RuntimeDialect(const CSVOptions<CharT>& options):
+      delimiter_(options.delimiter), quote_(options.quote), quoting_(options.quoting), crlf_(options.crlf), trim_(options.trim)
+    {
+      if(delimiter_ == '\n' || (quoting_ && (quote_ == delimiter_ || quote_ == '\n'))) throw std::runtime_error("invalid dialect.");
+    }
+
+    CharT delimiter() const noexcept { return delimiter_; }
+    CharT quote() const noexcept { return quote_; }
+    bool quoting() const noexcept { return quoting_; }
+    bool crlf() const noexcept { return crlf_; }
+    bool trim() const noexcept { return trim_; }
+
+  };
+
+  /// コンパイル時に固定した方言．StaticCSVParser に指定すると，解析の内側のループで方言に関する分岐が定数に畳み込まれる．
+  /// 特に囲み文字を使わない方言（Quoting = false）では，区切り文字と LF の位置を求めるだけの単純な 1 段目を用いる．
+  /// note: CSVOptions の delimiter, quote, quoting, crlf, trim は無視される．
+  template<char Delimiter, char Quote = '\"', bool Quoting = true, bool CRLF = true, bool Trim = false>
+  struct Dialect
+  {
+    static_assert(Delimiter != '\n' && (!Quoting || (Quote != Delimiter && Quote != '\n')), "invalid dialect.");
+
+    constexpr Dialect() noexcept = default;
+
+    template<class CharT>
+    explicit constexpr Dialect(const CSVOptions<CharT>&) noexcept
+    {}
+
+    static constexpr char delimiter() noexcept { return Delimiter; }
+    static constexpr char quote() noexcept { return Quote; }
+    static constexpr bool quoting() noexcept { return Quoting; }
+    static constexpr bool crlf() noexcept { return CRLF; }
+    static constexpr bool trim() noexcept { return Trim; }
+  };
+
+  /// RFC 4180 の CSV．
+  using CSVDialect = Dialect<','>;
+
+  /// 囲み文字を使わない TSV．
+  using TSVDialect = Dialect<'\t', '\"', false>;
+
+  template<class SourceT, class DialectT = RuntimeDialect<typename std::remove_reference_t<SourceT>::char_type>>
+  class StaticCSVParser;
+
+  /// 名前で指定した列を CSVHeader であらかじめ位置に解決したもの．CSVRecord の operator[] に渡すと位置による参照と同じ処理になる．
+  struct ColumnRef
+  {
+    std::size_t index;
+  };
+
+  /// ヘッダの列の名前と，名前から位置を引く表．
+  /// note: 名前を整列した位置の配列を二分探索する．同じ名前の列が複数ある場合は最初の列を返す．
+  template<class CharT>
+  class CSVHeader
+  {
+  public:
+
+    using char_type = CharT;
+    using string_view = std::basic_string_view<char_type>;
+
+  private:
+
+    std::vector<std::basic_string<char_type>> names_;
+    // 名前の順（同じ名前では位置の順）に並べた列の位置．
+    std::vector<std::size_t> order_;
+
+  public:
+
+    explicit CSVHeader(std::vector<std::basic_string<char_type>>&& names):
+      names_(std::move(names)), order_(names_.size())
+    {
+      for(std::size_t i = 0; i < order_.size(); ++i) order_[i] = i;
+      std::stable_sort(order_.begin(), order_.end(), [this](std::size_t lhs, std::size_t rhs){ return names_[lhs] < names_[rhs]; });
+    }
+
+    CSVHeader(CSVHeader&&) = default;
+    CSVHeader(const CSVHeader&) = default;
+    CSVHeader& operator=(CSVHeader&&) = default;
+    CSVHeader& operator=(const CSVHeader&) = default;
+
+    /// 列の数を返す．
+    std::size_t size() const noexcept
+    {
+      return names_.size();
+    }
+
+    /// i 番目の列の名前を返す．
+    string_view operator[](std::size_t i) const noexcept
+    {
+      assert(i < names_.size());
+      return names_[i];
+    }
+
+    const std::vector<std::basic_string<char_type>>& names() const noexcept
+    {
+      return names_;
+    }
+
+    /// name という名前の列の位置を返す．そのような列がない場合は std::nullopt を返す．
+    std::optional<std::size_t> find(string_view name) const noexcept
+    {
+      auto it = std::lower_bound(order_.begin(), order_.end(), name, [this](std::size_t i, string_view name){ return string_view(names_[i]) < name; });
+      if(it == order_.end() || names_[*it] != name) return std::nullopt;
+      return *it;
+    }
+
+    /// name という名前の列を返す．そのような列がない場合は例外を送出する．
+    ColumnRef column(string_view name) const
+    {
+      auto i = find(name);
+      if(!i) throw std::runtime_error("Cannot find column \"" + std::string(name.begin(), name.end()) + "\".");
+      return ColumnRef{*i};
+    }
+
+  // deleted:
+
+    CSVHeader() = delete;
+
+  };
+
+  /// AllocatorT は text_ などのレコードの内容を格納する領域の確保に用いる（ArenaAllocator 等）．
+  template<class CharT, class AllocatorT = std::allocator<CharT>>
   class CSVRecord
   {
     template<class>
     friend class CSVParser;
 
+    template<class, class>
+    friend class CSVRecord;
+
+    template<class>
+    friend class ParallelCSVParser;
+
   public:
 
     using char_type = CharT;
+    using allocator_type = AllocatorT;
     using string_view = std::basic_string_view<char_type>;
 
   private:
@@ -36,9 +216,11 @@ namespace ACCIO::CORE
     {
       std::size_t position_;
       std::size_t length_;
+      // note: nullptr でない場合は text_ ではなく入力のバッファを参照する．
+      const char_type* pointer_;
 
       FieldInfo(std::size_t position, std::size_t length):
-        position_(position), length_(length)
+        position_(position), length_(length), pointer_(nullptr)
       {}
 
       FieldInfo(FieldInfo&&) = default;
@@ -52,11 +234,85 @@ namespace ACCIO::CORE
   
     };
 
-    std::vector<FieldInfo> field_infos_;
-    std::vector<char_type> text_;
+    std::vector<FieldInfo, typename std::allocator_traits<allocator_type>::template rebind_alloc<FieldInfo>> field_infos_;
+    std::vector<char_type, allocator_type> text_;
+    // ヘッダを読み込んだ場合の列の名前の表．
+    std::shared_ptr<const CSVHeader<char_type>> header_;
+
+    // 入力のバッファを参照しているフィールドを text_ に写す．
+    void materialize()
+    {
+      for(auto&& field_info: field_infos_){
+        if(field_info.pointer_ != nullptr){
+          field_info.position_ = text_.size();
+          text_.insert(text_.end(), field_info.pointer_, field_info.pointer_ + field_info.length_);
+          text_.push_back('\0');
+          field_info.pointer_ = nullptr;
+        }
+      }
+    }
+
+    // other の内容を既存の領域に写す．入力のバッファを参照しているフィールドは写さずにそのまま参照する．
+    // note: 参照先のバッファが other と同じ期間だけ有効であることが分かっている場合（入力全体をマップした場合等）に用いる．
+    void assign_view(const CSVRecord& other)
+    {
+      field_infos_.assign(other.field_infos_.begin(), other.field_infos_.end());
+      text_.assign(other.text_.begin(), other.text_.end());
+      header_ = other.header_;
+    }
+
+    // columns で指定した列のみをこの順に残す．
+    void project(const std::vector<std::size_t>& columns)
+    {
+      decltype(field_infos_) field_infos(field_infos_.get_allocator());
+      field_infos.reserve(columns.size());
+      for(auto column: columns){
+        field_infos.push_back(column < field_infos_.size() ? field_infos_[column] : FieldInfo(text_.size(), 0));
+      }
+      field_infos_ = std::move(field_infos);
+    }
 
   public:
 
+    CSVRecord() = default;
+    CSVRecord(CSVRecord&&) = default;
+    CSVRecord& operator=(CSVRecord&&) = default;
+
+    CSVRecord(const CSVRecord& other):
+      field_infos_(other.field_infos_), text_(other.text_), header_(other.header_)
+    {
+      materialize();
+    }
+
+    CSVRecord& operator=(const CSVRecord& other)
+    {
+      field_infos_ = other.field_infos_;
+      text_ = other.text_;
+      header_ = other.header_;
+      materialize();
+      return *this;
+    }
+
+    /// other の内容を allocator で確保した領域にコピーする．
+    /// note: 必要な大きさを先に求めて一度に確保するので，コピーの途中で再確保は起こらない．
+    template<class OtherAllocatorT>
+    CSVRecord(const CSVRecord<char_type, OtherAllocatorT>& other, const allocator_type& allocator):
+      field_infos_(allocator), text_(allocator), header_(other.header_)
+    {
+      std::size_t text_size = other.text_.size();
+      for(const auto& field_info: other.field_infos_){
+        if(field_info.pointer_ != nullptr) text_size += field_info.length_ + 1;
+      }
+      field_infos_.reserve(other.field_infos_.size());
+      text_.reserve(text_size);
+      text_.insert(text_.end(), other.text_.begin(), other.text_.end());
+      for(const auto& field_info: other.field_infos_){
+        field_infos_.emplace_back(field_info.position_, field_info.length_);
+        field_infos_.back().pointer_ = field_info.pointer_;
+      }
+      materialize();
+    }
+
     /// record の要素数を返す．
     std::size_t size() const noexcept
     {
@@ -67,7 +323,53 @@ namespace ACCIO::CORE
     string_view operator[](std::size_t i) const noexcept
     {
       assert(i < field_infos_.size());
-      return string_view(text_.data() + field_infos_[i].position_, field_infos_[i].length_);
+      const auto& field_info = field_infos_[i];
+      if(field_info.pointer_ != nullptr){
+        return string_view(field_info.pointer_, field_info.length_);
+      }else{
+        return string_view(text_.data() + field_info.position_, field_info.length_);
+      }
+    }
+
+    /// i 番目の要素を T に変換して返す．変換できない場合は例外を送出する．
+    template<class T>
+    T get(std::size_t i) const
+    {
+      return FieldConverter<T>::convert(operator[](i));
+    }
+
+    /// ヘッダを読み込んだ場合はその表を，そうでなければ nullptr を返す．
+    const CSVHeader<char_type>* header() const noexcept
+    {
+      return header_.get();
+    }
+
+    /// column の要素を返す．record がその列を持たない場合は空となる．
+    string_view operator[](ColumnRef column) const noexcept
+    {
+      return column.index < field_infos_.size() ? operator[](column.index) : string_view();
+    }
+
+    /// name という名前の列の要素を返す．
+    /// note: 呼び出すたびに名前を探索するので，多くのレコードを読む場合は CSVParser::column() で得た ColumnRef を用いる．
+    string_view operator[](string_view name) const
+    {
+      if(header_ == nullptr) throw std::runtime_error("no header.");
+      return operator[](header_->column(name));
+    }
+
+    /// column の要素を T に変換して返す．変換できない場合は例外を送出する．
+    template<class T>
+    T get(ColumnRef column) const
+    {
+      return FieldConverter<T>::convert(operator[](column));
+    }
+
+    /// name という名前の列の要素を T に変換して返す．変換できない場合は例外を送出する．
+    template<class T>
+    T get(string_view name) const
+    {
+      return FieldConverter<T>::convert(operator[](name));
     }
 
     class Iterator
@@ -124,6 +426,12 @@ namespace ACCIO::CORE
   template<class CharT>
   class CSVParser
   {
+    template<class, class>
+    friend class StaticCSVParser;
+
+    template<class>
+    friend class AsyncCSVParser;
+
   public:
 
     using char_type = CharT;
@@ -135,6 +443,12 @@ namespace ACCIO::CORE
 
   private:
 
+    // CSVOptions::trim で取り除く空白であるか．
+    static bool is_space(char_type c) noexcept
+    {
+      return c == ' ' || c == '\t';
+    }
+
     class ImplBase
     {
     protected:
@@ -153,6 +467,12 @@ namespace ACCIO::CORE
 
       virtual void next() = 0;
 
+      /// 以降のレコードで取り出す列を指定する．
+      virtual void select(const std::vector<std::size_t>& columns) = 0;
+
+      /// 以降のレコードに付ける列の名前の表を指定する．
+      virtual void set_header(std::shared_ptr<const CSVHeader<char_type>> header) = 0;
+
     };
 
     template<class IteratorT, class LastIteratorT>
@@ -161,17 +481,45 @@ namespace ACCIO::CORE
     private:
 
       Record buffer_;
-      char_type delimiter_;
+      RuntimeDialect<char_type> dialect_;
       IteratorT current_;
       LastIteratorT last_;
+      std::vector<std::size_t> columns_;
+      // note: 破棄するときに共有の計測値に加える．
+      ACCIO_STATISTICS_CODE(STATISTICS::LocalCounters statistics_;)
+
+      // 最後のフィールドの前後の空白を取り除く．
+      void trim_back()
+      {
+        auto& field_info = buffer_.field_infos_.back();
+        while(field_info.length_ != 0 && is_space(buffer_.text_.back())){
+          buffer_.text_.pop_back();
+          --field_info.length_;
+        }
+        auto first = buffer_.text_.begin() + static_cast<std::ptrdiff_t>(field_info.position_);
+        auto last = std::find_if_not(first, buffer_.text_.end(), is_space);
+        field_info.length_ -= static_cast<std::size_t>(last - first);
+        buffer_.text_.erase(first, last);
+      }
 
     public:
 
       template<class T, class U>
-      Impl(T&& iterator, U&& last_iterator, char_type delimiter) noexcept:
-        ImplBase(), buffer_(), delimiter_(delimiter), current_(std::forward<T>(iterator)), last_(std::forward<U>(last_iterator))
+      Impl(T&& iterator, U&& last_iterator, const RuntimeDialect<char_type>& dialect) noexcept:
+        ImplBase(), buffer_(), dialect_(dialect), current_(std::forward<T>(iterator)), last_(std::forward<U>(last_iterator)), columns_()
       {}
 
+      // note: このクラスではレコード全体を解析してから列を選ぶ．
+      void select(const std::vector<std::size_t>& columns) override
+      {
+        columns_ = columns;
+      }
+
+      void set_header(std::shared_ptr<const CSVHeader<char_type>> header) override
+      {
+        buffer_.header_ = std::move(header);
+      }
+
       bool eof() const noexcept override
       {
         return current_ == last_;
@@ -193,12 +541,12 @@ namespace ACCIO::CORE
           buffer_.field_infos_.emplace_back(buffer_.text_.size(), 0);
           if(current_ == last_){
             break;
-          }else if(*current_ != double_quate){
+          }else if(!dialect_.quoting() || *current_ != dialect_.quote()){
             // In Field
             while(current_ != last_){
-              if(*current_ == delimiter_ || *current_ == line_feed){
+              if(*current_ == dialect_.delimiter() || *current_ == line_feed){
                 break;
-              }else if(*current_ == carriage_return){
+              }else if(dialect_.crlf() && *current_ == carriage_return){
                 ++current_;
                 // Next of CR
                 if(current_ != last_ && *current_ == line_feed){
@@ -207,7 +555,7 @@ namespace ACCIO::CORE
                   buffer_.text_.push_back(carriage_return);
                   ++(buffer_.field_infos_.back().length_);
                 }
-              }else if(*current_ == double_quate){
+              }else if(dialect_.quoting() && *current_ == dialect_.quote()){
                 throw std::runtime_error("unexpected double quate");
               }else{
                 buffer_.text_.push_back(*current_);
@@ -215,32 +563,36 @@ namespace ACCIO::CORE
                 ++current_;
               }
             }
+            if(dialect_.trim()){
+              trim_back();
+            }
           }else{
-            assert(*current_ == double_quate);
+            assert(*current_ == dialect_.quote());
+            ACCIO_STATISTICS_LOCAL_ADD(statistics_, quoted_fields, 1);
             ++current_;
             // In Enclosed Field
             while(true){
               if(current_ == last_){
                 throw std::runtime_error("unexpected EOF");
-              }else if(*current_ == double_quate){
+              }else if(*current_ == dialect_.quote()){
                 ++current_;
                 // Next of Double Quote
-                if(current_ == last_ || *current_ == delimiter_ || *current_ == line_feed){
+                if(current_ == last_ || *current_ == dialect_.delimiter() || *current_ == line_feed){
                   break;
                 }else if(*current_ == carriage_return){
                   ++current_;
                   // Next of CR
-                  if(current_ != last_ && *current_ == line_feed){
+                  if(dialect_.crlf() && current_ != last_ && *current_ == line_feed){
                     break;
                   }else{
-                    throw std::runtime_error("hoge");
+                    throw std::runtime_error("CR not followed by LF");
                   }
-                }else if(*current_ == double_quate){
-                  buffer_.text_.push_back(double_quate);
+                }else if(*current_ == dialect_.quote()){
+                  buffer_.text_.push_back(dialect_.quote());
                   ++(buffer_.field_infos_.back().length_);
                   ++current_;
                 }else{
-                  throw std::runtime_error("foo");
+                  throw std::runtime_error("unexpected character after closing quote");
                 }
               }else{
                 buffer_.text_.push_back(*current_);
@@ -249,7 +601,7 @@ namespace ACCIO::CORE
               }
             }
           }
-          assert(current_ == last_ || *current_ == delimiter_ || *current_ == line_feed);
+          assert(current_ == last_ || *current_ == dialect_.delimiter() || *current_ == line_feed);
           // End of Field
           buffer_.text_.push_back('\0');
           if(current_ == last_){
@@ -262,10 +614,521 @@ namespace ACCIO::CORE
           }
         }
         // End of Record
+        ACCIO_STATISTICS_LOCAL_ADD(statistics_, records, 1);
+        ACCIO_STATISTICS_LOCAL_ADD(statistics_, fields, buffer_.field_infos_.size());
+        if(!columns_.empty()){
+          buffer_.project(columns_);
+        }
       }
 
     };
 
+    // InputStream のように，バッファ上の連続した領域を peek_span() で参照し，consume() で読み進められる入力．
+    template<class T, class = void>
+    struct is_block_source: std::false_type {};
+
+    template<class T>
+    struct is_block_source<T, std::void_t<decltype(std::declval<T&>().peek_span().data()), decltype(std::declval<T&>().consume(std::size_t()))>>:
+      std::true_type
+    {};
+
+    // index_csv_structurals()（囲み文字を使わない方言では index_csv_separators()）と同じ規則で構造文字の位置を求める．1 バイトでない文字型に用いる．
+    template<class DialectT>
+    static std::size_t index_structurals_scalar(const char_type* s, std::size_t n, const DialectT& dialect, bool& in_quote, std::uint32_t* positions) noexcept
+    {
+      std::size_t count = 0;
+      for(std::size_t i = 0; i < n; ++i){
+        if(dialect.quoting() && s[i] == dialect.quote()){
+          in_quote = !in_quote;
+          positions[count++] = static_cast<std::uint32_t>(i);
+        }else if(!in_quote && (s[i] == dialect.delimiter() || s[i] == line_feed)){
+          positions[count++] = static_cast<std::uint32_t>(i);
+        }
+      }
+      return count;
+    }
+
+    // 入力をウィンドウごとに 2 段階で解析する．
+    // 1 段目で構造文字（ダブルクォートと，その外側の区切り文字・改行）の位置を SIMD 命令でまとめて求め（index_csv_structurals），
+    // 2 段目ではその位置だけを辿ってフィールドを切り出す．
+    // DialectT が Dialect の場合は，方言に関する分岐がコンパイル時に定まる．
+    template<class SourceT, class DialectT = RuntimeDialect<char_type>>
+    class BlockImpl final: public ImplBase
+    {
+    private:
+
+      static constexpr std::size_t window_size = 1 << 16;
+
+      // 2 段目でフィールドを処理している状態．
+      enum class FieldState
+      {
+        start,     // まだ何も読んでいない．
+        unquoted,  // ダブルクォートで囲まれていないフィールドの途中．
+        quoted,    // ダブルクォートで囲まれたフィールドの途中．
+        closed     // ダブルクォートで囲まれたフィールドの中で，ダブルクォートを読んだ直後．
+      };
+
+      Record buffer_;
+      DialectT dialect_;
+      bool zero_copy_;
+      SourceT source_;
+      std::unique_ptr<std::uint32_t[]> positions_;
+      std::size_t position_size_;
+      std::size_t position_index_;
+      const char_type* window_first_;
+      const char_type* window_last_;
+      const char_type* current_;
+      bool in_quote_;
+      // zero_copy_ の場合に，処理中のダブルクォートで囲まれたフィールドの内容のうち，まだ text_ に写していない部分．
+      const char_type* view_first_;
+      const char_type* view_last_;
+      // 処理中のフィールドが text_ を使っているか．
+      bool copying_;
+      // slots_[i] は i 列目を格納する要素の位置．空の場合はすべての列を取り出す．
+      std::vector<std::size_t> slots_;
+      std::size_t selected_size_;
+      // 処理中のフィールドの列番号と，それを格納する要素（取り出さない場合は nullptr）．
+      std::size_t column_;
+      typename Record::FieldInfo* field_;
+      // note: ウィンドウを進めるときと破棄するときに共有の計測値に加える．
+      ACCIO_STATISTICS_CODE(STATISTICS::LocalCounters statistics_;)
+
+      static constexpr std::size_t no_slot = std::numeric_limits<std::size_t>::max();
+
+      void start_field()
+      {
+        copying_ = false;
+        if(slots_.empty()){
+          buffer_.field_infos_.emplace_back(buffer_.text_.size(), 0);
+          field_ = &buffer_.field_infos_.back();
+        }else if(column_ < slots_.size() && slots_[column_] != no_slot){
+          field_ = &buffer_.field_infos_[slots_[column_]];
+          field_->position_ = buffer_.text_.size();
+        }else{
+          field_ = nullptr;
+        }
+      }
+
+      void advance_window()
+      {
+        ACCIO_STATISTICS_FLUSH(statistics_);
+        source_.consume(static_cast<std::size_t>(window_last_ - window_first_));
+        auto span = source_.peek_span();
+        auto n = std::min(span.size(), window_size);
+        window_first_ = span.data();
+        window_last_ = window_first_ + n;
+        current_ = window_first_;
+        if constexpr(sizeof(char_type) == 1){
+          auto s = reinterpret_cast<const char*>(window_first_);
+          if(dialect_.quoting()){
+            position_size_ = index_csv_structurals(s, n, static_cast<char>(dialect_.delimiter()), static_cast<char>(dialect_.quote()), in_quote_, positions_.get());
+          }else{
+            position_size_ = index_csv_separators(s, n, static_cast<char>(dialect_.delimiter()), positions_.get());
+          }
+        }else{
+          position_size_ = index_structurals_scalar(window_first_, n, dialect_, in_quote_, positions_.get());
+        }
+        position_index_ = 0;
+      }
+
+      // 処理中のフィールドの内容を text_ に書き込む前に呼ぶ．
+      // note: text_ の中でフィールドの順序を保つため，それまでに入力のバッファを参照しているフィールドを先に text_ に写す．
+      void begin_copy()
+      {
+        if(zero_copy_ && !copying_){
+          buffer_.materialize();
+          if(field_ != nullptr){
+            field_->position_ = buffer_.text_.size();
+          }
+          copying_ = true;
+        }
+      }
+
+      void append(const char_type* first, const char_type* last)
+      {
+        if(field_ == nullptr) return;
+        begin_copy();
+        buffer_.text_.insert(buffer_.text_.end(), first, last);
+      }
+
+      void append_view()
+      {
+        if(view_first_ != nullptr){
+          append(view_first_, view_last_);
+          view_first_ = nullptr;
+        }
+      }
+
+      // 処理中のフィールドの内容を入力のバッファ上の [first, last) とする．
+      void set_view(const char_type* first, const char_type* last)
+      {
+        if(field_ == nullptr) return;
+        field_->pointer_ = first;
+        field_->length_ = static_cast<std::size_t>(last - first);
+      }
+
+      // 処理中のフィールドを text_ 上で終える．
+      void end_field()
+      {
+        if(field_ != nullptr && field_->pointer_ == nullptr){
+          field_->length_ = buffer_.text_.size() - field_->position_;
+          buffer_.text_.push_back('\0');
+        }
+      }
+
+      // text_ 上の処理中のフィールドの前後の空白を取り除く．
+      void trim_text()
+      {
+        if(field_ == nullptr) return;
+        auto& text = buffer_.text_;
+        while(text.size() > field_->position_ && is_space(text.back())){
+          text.pop_back();
+        }
+        auto first = text.begin() + static_cast<std::ptrdiff_t>(field_->position_);
+        text.erase(first, std::find_if_not(first, text.end(), is_space));
+      }
+
+      // ダブルクォートで囲まれたフィールドの閉じダブルクォートの後に [first, last) が続いたときのエラーを送出する．
+      [[noreturn]] static void throw_after_closing_quote(const char_type* first, const char_type* last)
+      {
+        if(first != last && *first == carriage_return){
+          throw std::runtime_error("CR not followed by LF");
+        }else{
+          throw std::runtime_error("unexpected character after closing quote");
+        }
+      }
+
+      // ウィンドウの末尾に達したときに，処理中のフィールドの残りを取り込む．
+      void feed_rest(FieldState& state, bool& after_carriage_return)
+      {
+        switch(state){
+        case FieldState::start:
+        case FieldState::unquoted:
+          if(current_ != window_last_){
+            append(current_, window_last_);
+            state = FieldState::unquoted;
+          }
+          break;
+        case FieldState::quoted:
+          append_view();
+          append(current_, window_last_);
+          break;
+        case FieldState::closed:
+          append_view();
+          if(current_ != window_last_){
+            if(!dialect_.crlf() || after_carriage_return || *current_ != carriage_return || window_last_ - current_ > 1){
+              throw_after_closing_quote(after_carriage_return ? &carriage_return : current_, window_last_);
+            }
+            after_carriage_return = true;
+          }
+          break;
+        }
+      }
+
+      // 囲み文字を使わない方言の next()．フィールドの状態を持たず，区切り文字と LF の位置で切り出すだけである．
+      void next_unquoted()
+      {
+        ACCIO_STATISTICS_CODE(const char_type* record_first = current_; std::size_t record_size = 0;)
+        if(zero_copy_ && slots_.empty()){
+          // note: 最も多い場合（すべての列を入力のバッファを参照して取り出す）は，メンバを局所変数に置いてウィンドウ内のフィールドをまとめて切り出す．
+          // メンバのままでは，FieldInfo への書き込みのたびにコンパイラが別名の可能性を考えて読み直す．
+          auto positions = positions_.get();
+          auto index = position_index_;
+          auto size = position_size_;
+          auto window_first = window_first_;
+          auto current = current_;
+          auto& field_infos = buffer_.field_infos_;
+          bool end_of_record = false;
+          while(index != size){
+            const char_type* p = window_first + positions[index++];
+            auto first = current;
+            auto last = dialect_.crlf() && *p == line_feed && p != current && p[-1] == carriage_return ? p - 1 : p;
+            if(dialect_.trim()){
+              while(first != last && is_space(last[-1])) --last;
+              while(first != last && is_space(*first)) ++first;
+            }
+            auto& field_info = field_infos.back();
+            field_info.pointer_ = first;
+            field_info.length_ = static_cast<std::size_t>(last - first);
+            current = p + 1;
+            if(*p == line_feed){
+              end_of_record = true;
+              break;
+            }
+            field_infos.emplace_back(0, 0);
+          }
+          position_index_ = index;
+          current_ = current;
+          column_ = field_infos.size() - 1;
+          field_ = &field_infos.back();
+          if(end_of_record){
+            ACCIO_STATISTICS_CODE(record_size += static_cast<std::size_t>(current_ - record_first);)
+            if(current_ == window_last_){
+              buffer_.materialize();
+              advance_window();
+            }
+            ACCIO_STATISTICS_LOCAL_ADD(statistics_, records, 1);
+            ACCIO_STATISTICS_LOCAL_ADD(statistics_, fields, column_ + 1);
+            ACCIO_STATISTICS_LOCAL_MAX(statistics_, max_record_size, record_size);
+            return;
+          }
+        }
+        while(true){
+          if(position_index_ == position_size_){
+            // note: ウィンドウを進めると入力のバッファが無効になる．
+            begin_copy();
+            append(current_, window_last_);
+            ACCIO_STATISTICS_CODE(record_size += static_cast<std::size_t>(window_last_ - record_first);)
+            advance_window();
+            ACCIO_STATISTICS_CODE(record_first = window_first_;)
+            if(window_first_ == window_last_){
+              // EOF
+              if(dialect_.trim()){
+                trim_text();
+              }
+              end_field();
+              break;
+            }
+            continue;
+          }
+          const char_type* p = window_first_ + positions_[position_index_++];
+          assert(*p == dialect_.delimiter() || *p == line_feed);
+          // End of Field
+          if(zero_copy_ && !copying_){
+            // CRLF の CR はフィールドに含めない．
+            auto first = current_;
+            auto last = dialect_.crlf() && *p == line_feed && p != current_ && p[-1] == carriage_return ? p - 1 : p;
+            if(dialect_.trim()){
+              while(first != last && is_space(last[-1])) --last;
+              while(first != last && is_space(*first)) ++first;
+            }
+            set_view(first, last);
+          }else{
+            append(current_, p);
+            if(dialect_.crlf() && *p == line_feed && field_ != nullptr && buffer_.text_.size() > field_->position_ && buffer_.text_.back() == carriage_return){
+              buffer_.text_.pop_back();
+            }
+            if(dialect_.trim()){
+              trim_text();
+            }
+            end_field();
+          }
+          current_ = p + 1;
+          if(*p == line_feed){
+            ACCIO_STATISTICS_CODE(record_size += static_cast<std::size_t>(current_ - record_first);)
+            if(current_ == window_last_){
+              if(zero_copy_) buffer_.materialize();
+              advance_window();
+            }
+            break;
+          }
+          // Start of Field
+          ++column_;
+          start_field();
+        }
+        // End of Record
+        ACCIO_STATISTICS_LOCAL_ADD(statistics_, records, 1);
+        ACCIO_STATISTICS_LOCAL_ADD(statistics_, fields, column_ + 1);
+        ACCIO_STATISTICS_LOCAL_MAX(statistics_, max_record_size, record_size);
+      }
+
+    public:
+
+      template<class T>
+      BlockImpl(T&& source, const CSVOptions<char_type>& options):
+        ImplBase(), buffer_(), dialect_(options), zero_copy_(options.zero_copy), source_(std::forward<T>(source)),
+        positions_(std::make_unique<std::uint32_t[]>(window_size + index_padding)), position_size_(0), position_index_(0),
+        window_first_(nullptr), window_last_(nullptr), current_(nullptr), in_quote_(false), view_first_(nullptr), view_last_(nullptr), copying_(false),
+        slots_(), selected_size_(0), column_(0), field_(nullptr)
+      {
+        advance_window();
+      }
+
+      bool eof() const noexcept override
+      {
+        return current_ == window_last_;
+      }
+
+      /// source_ に入力が追加された場合に呼ぶ．eof() の状態であれば，追加された入力から読み込みを再開する．
+      /// note: 入力を追加できるのはレコードの境界までであり，それまでのレコードはすべて読み終えている必要がある．
+      void refresh()
+      {
+        if(current_ == window_last_) advance_window();
+      }
+
+      const Record& get() const noexcept override
+      {
+        return buffer_;
+      }
+
+      void select(const std::vector<std::size_t>& columns) override
+      {
+        slots_.clear();
+        for(std::size_t i = 0; i < columns.size(); ++i){
+          if(columns[i] >= slots_.size()){
+            slots_.resize(columns[i] + 1, no_slot);
+          }
+          slots_[columns[i]] = i;
+        }
+        selected_size_ = columns.size();
+      }
+
+      void set_header(std::shared_ptr<const CSVHeader<char_type>> header) override
+      {
+        buffer_.header_ = std::move(header);
+      }
+
+      void next() override
+      {
+        assert(!eof());
+        buffer_.field_infos_.clear();
+        buffer_.text_.clear();
+        // Start of Record
+        if(!slots_.empty()){
+          buffer_.field_infos_.assign(selected_size_, typename Record::FieldInfo(0, 0));
+        }
+        column_ = 0;
+        start_field();
+        if(!dialect_.quoting()){
+          next_unquoted();
+          return;
+        }
+        auto state = FieldState::start;
+        bool after_carriage_return = false;
+        // note: 計測値はレコードの終わりにまとめて加える．
+        ACCIO_STATISTICS_CODE(const char_type* record_first = current_; std::size_t record_size = 0; std::size_t quoted_fields = 0;)
+        while(true){
+          if(position_index_ == position_size_){
+            // note: ウィンドウを進めると入力のバッファが無効になる．
+            begin_copy();
+            feed_rest(state, after_carriage_return);
+            ACCIO_STATISTICS_CODE(record_size += static_cast<std::size_t>(window_last_ - record_first);)
+            advance_window();
+            ACCIO_STATISTICS_CODE(record_first = window_first_;)
+            if(window_first_ == window_last_){
+              // EOF
+              if(state == FieldState::quoted){
+                throw std::runtime_error("unexpected EOF");
+              }else if(after_carriage_return){
+                throw std::runtime_error("CR not followed by LF");
+              }
+              if(dialect_.trim() && state != FieldState::closed){
+                trim_text();
+              }
+              end_field();
+              break;
+            }
+            continue;
+          }
+          const char_type* p = window_first_ + positions_[position_index_++];
+          // note: 囲み文字を使わない方言では，1 段目が区切り文字と LF の位置しか返さないので，フィールドは常に start か unquoted の状態にある．
+          if(dialect_.quoting() && *p == dialect_.quote()){
+            switch(state){
+            case FieldState::start:
+              if(p != current_) throw std::runtime_error("unexpected double quate");
+              if(zero_copy_ && field_ != nullptr){
+                view_first_ = view_last_ = p + 1;
+              }
+              ACCIO_STATISTICS_CODE(++quoted_fields;)
+              state = FieldState::quoted;
+              break;
+            case FieldState::unquoted:
+              throw std::runtime_error("unexpected double quate");
+            case FieldState::quoted:
+              if(view_first_ != nullptr){
+                view_last_ = p;
+              }else{
+                append(current_, p);
+              }
+              state = FieldState::closed;
+              break;
+            case FieldState::closed:
+              // 連続する 2 つのダブルクォートは 1 つのダブルクォートを表す．
+              if(p != current_ || after_carriage_return) throw_after_closing_quote(after_carriage_return ? &carriage_return : current_, p);
+              append_view();
+              append(p, p + 1);
+              state = FieldState::quoted;
+              break;
+            }
+            current_ = p + 1;
+            continue;
+          }
+          assert(*p == dialect_.delimiter() || *p == line_feed);
+          assert(state != FieldState::quoted);
+          // End of Field
+          if(state == FieldState::closed){
+            auto rest = p - current_;
+            bool crlf = dialect_.crlf() && *p == line_feed && ((after_carriage_return && rest == 0) || (!after_carriage_return && rest == 1 && *current_ == carriage_return));
+            if(!crlf && (rest != 0 || after_carriage_return)){
+              throw_after_closing_quote(after_carriage_return ? &carriage_return : current_, p);
+            }
+          }else if(state == FieldState::start && zero_copy_){
+            // CRLF の CR はフィールドに含めない．
+            auto first = current_;
+            auto last = dialect_.crlf() && *p == line_feed && p != current_ && p[-1] == carriage_return ? p - 1 : p;
+            if(dialect_.trim()){
+              while(first != last && is_space(last[-1])) --last;
+              while(first != last && is_space(*first)) ++first;
+            }
+            set_view(first, last);
+          }else{
+            append(current_, p);
+            // CRLF の CR はフィールドに含めない．
+            if(dialect_.crlf() && *p == line_feed && field_ != nullptr && buffer_.text_.size() > field_->position_ && buffer_.text_.back() == carriage_return){
+              buffer_.text_.pop_back();
+            }
+            if(dialect_.trim()){
+              trim_text();
+            }
+          }
+          if(state == FieldState::closed && view_first_ != nullptr){
+            set_view(view_first_, view_last_);
+            view_first_ = nullptr;
+          }else{
+            end_field();
+          }
+          current_ = p + 1;
+          if(*p == line_feed){
+            ACCIO_STATISTICS_CODE(record_size += static_cast<std::size_t>(current_ - record_first);)
+            // note: eof() を正しく判定できるように，ウィンドウを読み切ったら次のウィンドウに進めておく．
+            if(current_ == window_last_){
+              if(zero_copy_) buffer_.materialize();
+              advance_window();
+            }
+            break;
+          }
+          // Start of Field
+          ++column_;
+          start_field();
+          state = FieldState::start;
+          after_carriage_return = false;
+        }
+        // End of Record
+        ACCIO_STATISTICS_LOCAL_ADD(statistics_, records, 1);
+        ACCIO_STATISTICS_LOCAL_ADD(statistics_, fields, column_ + 1);
+        ACCIO_STATISTICS_LOCAL_ADD(statistics_, quoted_fields, quoted_fields);
+        ACCIO_STATISTICS_LOCAL_MAX(statistics_, max_record_size, record_size);
+      }
+
+    };
+
+    // note: zero_copy は BlockImpl の場合のみ有効である．
+    template<class InputStreamT>
+    static std::unique_ptr<ImplBase> make_impl(InputStreamT&& input_stream, const CSVOptions<char_type>& options)
+    {
+      using StreamT = std::remove_cv_t<std::remove_reference_t<InputStreamT>>;
+      if constexpr(is_block_source<StreamT>::value){
+        return std::make_unique<BlockImpl<InputStreamT>>(std::forward<InputStreamT>(input_stream), options);
+      }else if constexpr(std::is_same_v<StreamT, std::basic_string<char_type>> && !std::is_lvalue_reference_v<InputStreamT>){
+        return std::make_unique<BlockImpl<StringInputStream<char_type>>>(StringInputStream<char_type>(std::move(input_stream)), options);
+      }else if constexpr(std::is_same_v<StreamT, std::basic_string<char_type>> || std::is_same_v<StreamT, std::basic_string_view<char_type>>){
+        // note: 左辺値の文字列は ImplWithCapturing と同様に所有せずに参照する．
+        return std::make_unique<BlockImpl<SpanInputStream<char_type>>>(SpanInputStream<char_type>(input_stream.data(), input_stream.data() + input_stream.size()), options);
+      }else{
+        return std::make_unique<ImplWithCapturing<InputStreamT>>(std::forward<InputStreamT>(input_stream), RuntimeDialect<char_type>(options));
+      }
+    }
+
     template<class InputStreamT>
     class Capturer
     {
@@ -288,14 +1151,62 @@ namespace ACCIO::CORE
     {
     public:
 
-      ImplWithCapturing(InputStreamT&& input_stream, char_type delimiter):
+      ImplWithCapturing(InputStreamT&& input_stream, const RuntimeDialect<char_type>& dialect):
         Capturer<InputStreamT>(std::move(input_stream)),
         Impl<std::remove_cv_t<std::remove_reference_t<decltype(std::declval<InputStreamT&>().begin())>>,
              std::remove_cv_t<std::remove_reference_t<decltype(std::declval<InputStreamT&>().end())>>>(
-               std::begin(Capturer<InputStreamT>::input_stream_), std::end(Capturer<InputStreamT>::input_stream_), delimiter)
+               std::begin(Capturer<InputStreamT>::input_stream_), std::end(Capturer<InputStreamT>::input_stream_), dialect)
       {}
     };
 
+    // options に従って取り出す列を impl に指定する．列を名前で指定した場合やヘッダを読み込む場合は先頭のレコードを読み飛ばす．
+    // 取り出す列に重複があれば例外を送出する．
+    static void check_unique_columns(std::vector<std::size_t> columns)
+    {
+      std::sort(columns.begin(), columns.end());
+      if(std::adjacent_find(columns.begin(), columns.end()) != columns.end()) throw std::runtime_error("duplicate column.");
+    }
+
+    // CSVOptions::header が true の場合は列の名前の表を impl に指定して返し，そうでなければ nullptr を返す．
+    template<class ImplT>
+    static std::shared_ptr<const CSVHeader<char_type>> select_columns(ImplT& impl, const CSVOptions<char_type>& options)
+    {
+      std::vector<std::basic_string<char_type>> names;
+      if(options.header || !options.column_names.empty()){
+        if(impl.eof()){
+          return options.header ? std::make_shared<const CSVHeader<char_type>>(std::move(names)) : nullptr;
+        }
+        impl.next();
+        for(auto field: impl.get()) names.emplace_back(field);
+      }
+      if(!options.column_names.empty()){
+        std::vector<std::size_t> columns;
+        for(const auto& name: options.column_names){
+          std::size_t i = 0;
+          while(i < names.size() && names[i] != name) ++i;
+          if(i == names.size()) throw std::runtime_error("Cannot find column \"" + std::string(name.begin(), name.end()) + "\".");
+          columns.push_back(i);
+        }
+        check_unique_columns(columns);
+        impl.select(columns);
+        names = options.column_names;
+      }else if(!options.columns.empty()){
+        check_unique_columns(options.columns);
+        impl.select(options.columns);
+        if(options.header){
+          std::vector<std::basic_string<char_type>> selected;
+          for(auto column: options.columns){
+            selected.push_back(column < names.size() ? names[column] : std::basic_string<char_type>());
+          }
+          names = std::move(selected);
+        }
+      }
+      if(!options.header) return nullptr;
+      auto header = std::make_shared<const CSVHeader<char_type>>(std::move(names));
+      impl.set_header(header);
+      return header;
+    }
+
     class LastIterator;
 
     class Iterator
@@ -366,13 +1277,20 @@ namespace ACCIO::CORE
 
 
     std::unique_ptr<ImplBase> impl_;
+    std::shared_ptr<const CSVHeader<char_type>> header_;
 
   public:
 
     template<class InputStreamT>
     CSVParser(InputStreamT&& stream, char_type delimiter):
-      impl_(std::make_unique<ImplWithCapturing<InputStreamT>>(std::forward<InputStreamT>(stream), delimiter))
+      CSVParser(std::forward<InputStreamT>(stream), CSVOptions<char_type>{delimiter})
+    {}
+
+    template<class InputStreamT>
+    CSVParser(InputStreamT&& stream, const CSVOptions<char_type>& options):
+      impl_(make_impl(std::forward<InputStreamT>(stream), options)), header_()
     {
+      header_ = select_columns(*impl_, options);
       if(impl_->eof()){
         impl_ = nullptr;
       }else{
@@ -383,7 +1301,8 @@ namespace ACCIO::CORE
     template<class IteratorT, class LastIteratorT>
     CSVParser(IteratorT&& first, LastIteratorT&& last, char_type delimiter):
       impl_(std::make_unique<Impl<std::remove_cv_t<std::remove_reference_t<IteratorT>>, std::remove_cv_t<std::remove_reference_t<LastIteratorT>>>>(
-        std::forward<IteratorT>(first), std::forward<LastIteratorT>(last), delimiter))
+        std::forward<IteratorT>(first), std::forward<LastIteratorT>(last), RuntimeDialect<char_type>(CSVOptions<char_type>{delimiter}))),
+      header_()
     {
       if(impl_->eof()){
         impl_ = nullptr;
@@ -402,6 +1321,265 @@ namespace ACCIO::CORE
       return {};
     }
 
+    /// ヘッダを読み込んだ場合（CSVOptions::header）はその表を，そうでなければ nullptr を返す．
+    const CSVHeader<char_type>* header() const noexcept
+    {
+      return header_.get();
+    }
+
+    /// name という名前の列を返す．読み込みの前に一度だけ呼び出し，各レコードでは返した ColumnRef で列を参照する．
+    ColumnRef column(std::basic_string_view<char_type> name) const
+    {
+      if(header_ == nullptr) throw std::runtime_error("no header.");
+      return header_->column(name);
+    }
+
+  };
+
+  /// CSVParser と同様に source を解析するが，入力の型を SourceT に固定して型消去を行わない．
+  /// SourceT は peek_span() と consume() を持つ必要がある（InputStream, SpanInputStream 等）．
+  /// note: InputStream<char8_t, U8DecoderFromUTF8<std::unique_ptr<BinaryFileReader>>> のように final なクラスで合成すれば，
+  /// 読み込みから解析までが仮想関数呼び出しを介さずにインライン展開されうる．
+  /// DialectT に Dialect（CSVDialect, TSVDialect 等）を指定すると，その方言に特化した解析を行う．
+  template<class SourceT, class DialectT>
+  class StaticCSVParser
+  {
+  public:
+
+    using char_type = typename std::remove_reference_t<SourceT>::char_type;
+    using Record = CSVRecord<char_type>;
+
+  private:
+
+    using Impl = typename CSVParser<char_type>::template BlockImpl<SourceT, DialectT>;
+
+    // note: Impl は入力のバッファを指すポインタを持つので，StaticCSVParser はムーブできない．
+    Impl impl_;
+    std::shared_ptr<const CSVHeader<char_type>> header_;
+    bool end_;
+
+    class LastIterator;
+
+    class Iterator
+    {
+    private:
+
+      StaticCSVParser& parser_;
+
+    public:
+
+      explicit Iterator(StaticCSVParser& parser):
+        parser_(parser)
+      {}
+
+      Iterator(Iterator&&) = default;
+
+      bool operator==(const LastIterator&) const noexcept
+      {
+        return parser_.end_;
+      }
+
+      bool operator!=(const LastIterator&) const noexcept
+      {
+        return !parser_.end_;
+      }
+
+      const Record& operator*() const noexcept
+      {
+        assert(!parser_.end_);
+        return parser_.impl_.get();
+      }
+
+      Iterator& operator++()
+      {
+        assert(!parser_.end_);
+        if(parser_.impl_.eof()){
+          parser_.end_ = true;
+        }else{
+          parser_.impl_.next();
+        }
+        return *this;
+      }
+
+    // deleted:
+
+      Iterator() = delete;
+      Iterator(const Iterator&) = delete;
+      Iterator& operator=(Iterator&&) = delete;
+      Iterator& operator=(const Iterator&) = delete;
+
+    };
+
+    class LastIterator
+    {
+    public:
+
+      bool operator==(const Iterator& rhs) const noexcept
+      {
+        return rhs == *this;
+      }
+
+      bool operator!=(const Iterator& rhs) const noexcept
+      {
+        return rhs != *this;
+      }
+
+    };
+
+  public:
+
+    template<class T>
+    StaticCSVParser(T&& source, const CSVOptions<char_type>& options):
+      impl_(std::forward<T>(source), options), header_(), end_(false)
+    {
+      header_ = CSVParser<char_type>::select_columns(impl_, options);
+      end_ = impl_.eof();
+      if(!end_){
+        impl_.next();
+      }
+    }
+
+    Iterator begin() noexcept
+    {
+      return Iterator(*this);
+    }
+
+    LastIterator end() noexcept
+    {
+      return {};
+    }
+
+    /// ヘッダを読み込んだ場合（CSVOptions::header）はその表を，そうでなければ nullptr を返す．
+    const CSVHeader<char_type>* header() const noexcept
+    {
+      return header_.get();
+    }
+
+    /// name という名前の列を返す．読み込みの前に一度だけ呼び出し，各レコードでは返した ColumnRef で列を参照する．
+    ColumnRef column(std::basic_string_view<char_type> name) const
+    {
+      if(header_ == nullptr) throw std::runtime_error("no header.");
+      return header_->column(name);
+    }
+
+  // deleted:
+
+    StaticCSVParser() = delete;
+    StaticCSVParser(StaticCSVParser&&) = delete;
+    StaticCSVParser(const StaticCSVParser&) = delete;
+    StaticCSVParser& operator=(StaticCSVParser&&) = delete;
+    StaticCSVParser& operator=(const StaticCSVParser&) = delete;
+
+  };
+
+  /// ParserT が返すレコードを，読み進めるたびに SchemaT に従って std::tuple に変換して返す．
+  template<class SchemaT, class ParserT>
+  class TypedCSVParser
+  {
+  public:
+
+    using value_type = typename SchemaT::tuple_type;
+
+  private:
+
+    using ParserIterator = decltype(std::declval<ParserT&>().begin());
+    using ParserLastIterator = decltype(std::declval<ParserT&>().end());
+
+    ParserT parser_;
+
+    class LastIterator;
+
+    class Iterator
+    {
+    private:
+
+      ParserIterator current_;
+      ParserLastIterator last_;
+      std::optional<value_type> value_;
+
+      void convert()
+      {
+        if(current_ != last_){
+          value_ = SchemaT::convert(*current_);
+        }
+      }
+
+    public:
+
+      Iterator(ParserIterator&& current, ParserLastIterator&& last):
+        current_(std::move(current)), last_(std::move(last)), value_()
+      {
+        convert();
+      }
+
+      Iterator(Iterator&&) = default;
+
+      bool operator==(const LastIterator&) const noexcept
+      {
+        return current_ == last_;
+      }
+
+      bool operator!=(const LastIterator&) const noexcept
+      {
+        return current_ != last_;
+      }
+
+      const value_type& operator*() const noexcept
+      {
+        assert(value_);
+        return *value_;
+      }
+
+      Iterator& operator++()
+      {
+        ++current_;
+        convert();
+        return *this;
+      }
+
+    // deleted:
+
+      Iterator() = delete;
+      Iterator(const Iterator&) = delete;
+      Iterator& operator=(Iterator&&) = delete;
+      Iterator& operator=(const Iterator&) = delete;
+
+    };
+
+    class LastIterator
+    {
+    public:
+
+      bool operator==(const Iterator& rhs) const noexcept
+      {
+        return rhs == *this;
+      }
+
+      bool operator!=(const Iterator& rhs) const noexcept
+      {
+        return rhs != *this;
+      }
+
+    };
+
+  public:
+
+    /// 引数はそのまま ParserT のコンストラクタに渡す．
+    template<class... Args>
+    explicit TypedCSVParser(Args&&... args):
+      parser_(std::forward<Args>(args)...)
+    {}
+
+    Iterator begin()
+    {
+      return Iterator(parser_.begin(), parser_.end());
+    }
+
+    LastIterator end() noexcept
+    {
+      return {};
+    }
+
   };
 
 }
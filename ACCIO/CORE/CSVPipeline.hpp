@@ -0,0 +1,311 @@
+#ifndef ACCIO_CORE_CSVPIPELINE_HPP_
+#define ACCIO_CORE_CSVPIPELINE_HPP_
+
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <exception>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "CSVParser.hpp"
+#include "LockFreeQueue.hpp"
+
+
+namespace ACCIO::CORE
+{
+
+  template<class CharT>
+  class RecordBufferPool;
+
+  template<class ParserT, template<class> class QueueT>
+  class CSVPipeline;
+
+  /// 再利用できるレコードの組．
+  /// note: clear() しても各レコードの領域は解放しないので，繰り返し使うと確保が起こらなくなる．
+  template<class CharT>
+  class RecordBuffer
+  {
+    template<class, template<class> class>
+    friend class CSVPipeline;
+
+  public:
+
+    using char_type = CharT;
+    using Record = CSVRecord<char_type>;
+
+  private:
+
+    std::vector<Record> records_;
+    std::size_t size_;
+    std::size_t first_row_;
+
+  public:
+
+    RecordBuffer():
+      records_(), size_(0), first_row_(0)
+    {}
+
+    std::size_t size() const noexcept
+    {
+      return size_;
+    }
+
+    bool empty() const noexcept
+    {
+      return size_ == 0;
+    }
+
+    /// 先頭のレコードが入力の中で何番目のレコードか．
+    std::size_t first_row() const noexcept
+    {
+      return first_row_;
+    }
+
+    const Record& operator[](std::size_t i) const noexcept
+    {
+      assert(i < size_);
+      return records_[i];
+    }
+
+    /// record を末尾にコピーする．以前に使った要素があれば，その領域に上書きする．
+    void push_back(const Record& record)
+    {
+      if(size_ < records_.size()){
+        records_[size_] = record;
+      }else{
+        records_.push_back(record);
+      }
+      ++size_;
+    }
+
+    void clear() noexcept
+    {
+      size_ = 0;
+      first_row_ = 0;
+    }
+
+    auto begin() const noexcept
+    {
+      return records_.begin();
+    }
+
+    auto end() const noexcept
+    {
+      return records_.begin() + static_cast<std::ptrdiff_t>(size_);
+    }
+
+  };
+
+  /// 決まった数の RecordBuffer を持ち，複数のスレッドの間で貸し出しと返却を行う．
+  /// 空きのバッファはロックフリーなキューで管理する．
+  template<class CharT>
+  class RecordBufferPool
+  {
+  public:
+
+    using Buffer = RecordBuffer<CharT>;
+
+    /// 破棄されるときにバッファを空にしてプールに返す．
+    class Releaser
+    {
+    private:
+
+      RecordBufferPool* pool_;
+
+    public:
+
+      explicit Releaser(RecordBufferPool* pool = nullptr) noexcept:
+        pool_(pool)
+      {}
+
+      void operator()(Buffer* buffer) const noexcept
+      {
+        pool_->release(buffer);
+      }
+
+    };
+
+    /// 貸し出したバッファ．破棄するとプールに返される．
+    /// note: プールより先に破棄する必要がある．
+    using BufferPtr = std::unique_ptr<Buffer, Releaser>;
+
+  private:
+
+    std::vector<std::unique_ptr<Buffer>> buffers_;
+    MPMCQueue<Buffer*> free_;
+
+  public:
+
+    explicit RecordBufferPool(std::size_t buffers):
+      buffers_(), free_(buffers)
+    {
+      for(std::size_t i = 0; i < std::max<std::size_t>(buffers, 1); ++i){
+        buffers_.push_back(std::make_unique<Buffer>());
+        free_.try_push(buffers_.back().get());
+      }
+    }
+
+    /// バッファの数を返す．
+    std::size_t size() const noexcept
+    {
+      return buffers_.size();
+    }
+
+    /// 空きのバッファを返す．空きがない場合は空の BufferPtr を返す．
+    BufferPtr try_acquire()
+    {
+      Buffer* buffer = nullptr;
+      free_.try_pop(buffer);
+      return BufferPtr(buffer, Releaser(this));
+    }
+
+    /// 空きのバッファを待って返す．待っている間に stop() が true を返した場合は空の BufferPtr を返す．
+    template<class F>
+    BufferPtr acquire(F&& stop)
+    {
+      Backoff backoff;
+      while(true){
+        if(auto buffer = try_acquire()) return buffer;
+        if(stop()) return BufferPtr(nullptr, Releaser(this));
+        backoff.pause();
+      }
+    }
+
+    /// buffer を空にしてプールに返す．
+    void release(Buffer* buffer) noexcept
+    {
+      buffer->clear();
+      // note: 容量はバッファの数以上なので，返却は必ず成功する．
+      auto ret = free_.try_push(std::move(buffer));
+      assert(ret); static_cast<void>(ret);
+    }
+
+  // deleted:
+
+    RecordBufferPool() = delete;
+    RecordBufferPool(RecordBufferPool&&) = delete;
+    RecordBufferPool(const RecordBufferPool&) = delete;
+    RecordBufferPool& operator=(RecordBufferPool&&) = delete;
+    RecordBufferPool& operator=(const RecordBufferPool&) = delete;
+
+  };
+
+  /// parser を専用のスレッドで読み進め，レコードを batch_size 個ずつ RecordBuffer に詰めてキューに渡す．
+  /// 利用側は pop() でバッファを受け取り，処理し終えたら破棄してプールに返す．空きのバッファがない間は解析が止まる．
+  /// QueueT は解析済みのバッファを渡すキューであり，pop() を 1 つのスレッドからのみ呼ぶ場合は SPSCQueue を指定できる．
+  template<class ParserT, template<class> class QueueT = MPMCQueue>
+  class CSVPipeline
+  {
+  public:
+
+    using Record = std::remove_cv_t<std::remove_reference_t<decltype(*std::declval<ParserT&>().begin())>>;
+    using char_type = typename Record::char_type;
+    using Buffer = RecordBuffer<char_type>;
+    using BufferPtr = typename RecordBufferPool<char_type>::BufferPtr;
+
+    static constexpr std::size_t default_buffers = 8;
+    static constexpr std::size_t default_batch_size = 4096;
+
+  private:
+
+    ParserT parser_;
+    std::size_t batch_size_;
+    RecordBufferPool<char_type> pool_;
+    // note: 容量はバッファの数以上なので，追加は必ず成功する．
+    QueueT<Buffer*> ready_;
+    std::atomic<bool> done_;
+    std::atomic<bool> stop_;
+    // note: done_ が true になった後にのみ読む．
+    std::exception_ptr exception_;
+    std::thread thread_;
+
+    void run() noexcept
+    {
+      BufferPtr buffer;
+      try{
+        std::size_t first_row = 0;
+        for(auto&& record: parser_){
+          if(buffer == nullptr){
+            if(stop_.load(std::memory_order_acquire)) break;
+            buffer = pool_.acquire([this]{ return stop_.load(std::memory_order_acquire); });
+            if(buffer == nullptr) break;
+            buffer->first_row_ = first_row;
+          }
+          buffer->push_back(record);
+          if(buffer->size() == batch_size_){
+            first_row += buffer->size();
+            publish(std::move(buffer));
+          }
+        }
+      }catch(...){
+        exception_ = std::current_exception();
+      }
+      // note: 例外が送出された場合も，それまでに解析したレコードを渡す．
+      if(buffer != nullptr) publish(std::move(buffer));
+      done_.store(true, std::memory_order_release);
+    }
+
+    void publish(BufferPtr&& buffer)
+    {
+      auto ret = ready_.try_push(buffer.release());
+      assert(ret); static_cast<void>(ret);
+    }
+
+  public:
+
+    /// buffers 個のバッファを用意し，parser の解析を始める．
+    template<class T>
+    explicit CSVPipeline(T&& parser, std::size_t buffers = default_buffers, std::size_t batch_size = default_batch_size):
+      parser_(std::forward<T>(parser)), batch_size_(std::max<std::size_t>(batch_size, 1)), pool_(buffers), ready_(pool_.size()),
+      done_(false), stop_(false), exception_(), thread_()
+    {
+      thread_ = std::thread([this]{ run(); });
+    }
+
+    /// 解析を打ち切り，スレッドの終了を待つ．
+    /// note: pop() で受け取ったバッファは先に破棄する必要がある．
+    ~CSVPipeline()
+    {
+      stop_.store(true, std::memory_order_release);
+      thread_.join();
+      Buffer* buffer;
+      while(ready_.try_pop(buffer)){
+        pool_.release(buffer);
+      }
+    }
+
+    /// 次のバッファを待って返す．全てのレコードを返し終えた場合は空の BufferPtr を返す．
+    /// 解析中に例外が送出された場合は，それまでのバッファを返した後にその例外を再送出する．
+    BufferPtr pop()
+    {
+      Backoff backoff;
+      Buffer* buffer;
+      while(true){
+        if(ready_.try_pop(buffer)) return BufferPtr(buffer, typename RecordBufferPool<char_type>::Releaser(&pool_));
+        if(done_.load(std::memory_order_acquire)){
+          // note: done_ を見た後に読み直せば，最後に追加されたバッファも見える．
+          if(ready_.try_pop(buffer)) return BufferPtr(buffer, typename RecordBufferPool<char_type>::Releaser(&pool_));
+          if(exception_ != nullptr) std::rethrow_exception(exception_);
+          return BufferPtr(nullptr, typename RecordBufferPool<char_type>::Releaser(&pool_));
+        }
+        backoff.pause();
+      }
+    }
+
+  // deleted:
+
+    CSVPipeline() = delete;
+    CSVPipeline(CSVPipeline&&) = delete;
+    CSVPipeline(const CSVPipeline&) = delete;
+    CSVPipeline& operator=(CSVPipeline&&) = delete;
+    CSVPipeline& operator=(const CSVPipeline&) = delete;
+
+  };
+
+}
+
+
+#endif
@@ -0,0 +1,225 @@
+#ifndef ACCIO_CORE_CSVWRITER_HPP_
+#define ACCIO_CORE_CSVWRITER_HPP_
+
+
+#include <cassert>
+#include <charconv>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include "char8_t.hpp"
+#include "FieldConverter.hpp"
+#include "OutputStream.hpp"
+#include "SIMD.hpp"
+
+
+namespace ACCIO::CORE
+{
+
+  /// レコードを CSV として OutputStreamT に書き込む．
+  /// フィールドは区切り文字，ダブルクォート，CR，LF を含む場合のみダブルクォートで囲む．数値は std::to_chars で出力バッファに直接書き込む．
+  template<class CharT, class OutputStreamT = OutputStream<CharT>>
+  class CSVWriter
+  {
+  public:
+
+    using char_type = CharT;
+
+  private:
+
+    static constexpr char_type double_quate = '\"';
+    static constexpr char_type line_feed = '\n';
+    // note: std::to_chars で書き込む数値の最大の長さ．
+    static constexpr std::size_t max_number_length = 64;
+
+    template<class T>
+    struct is_optional: std::false_type {};
+
+    template<class T>
+    struct is_optional<std::optional<T>>: std::true_type {};
+
+    template<class T>
+    struct is_tuple: std::false_type {};
+
+    template<class... Ts>
+    struct is_tuple<std::tuple<Ts...>>: std::true_type {};
+
+    // 文字として書き込む型（数値としては書き込まない）．
+    template<class T>
+    static constexpr bool is_character_v = std::is_same_v<T, char_type> || std::is_same_v<T, char> || std::is_same_v<T, char8_t>;
+
+    // 1 バイトの文字型どうしであれば，文字列をバイト列として読み替えて書き込める．
+    template<class T, class U>
+    static constexpr bool is_byte_string_v = sizeof(char_type) == 1 && std::is_convertible_v<const T&, std::basic_string_view<U>>;
+
+    OutputStreamT stream_;
+    char_type delimiter_;
+    // 処理中のレコードにまだフィールドを書き込んでいないか．
+    bool first_field_;
+
+    void start_field()
+    {
+      if(!first_field_){
+        stream_.put(delimiter_);
+      }
+      first_field_ = false;
+    }
+
+    void write_string(std::basic_string_view<char_type> s)
+    {
+      if(!needs_csv_quote(reinterpret_cast<const char*>(s.data()), s.size(), static_cast<char>(delimiter_))){
+        stream_.write(s);
+        return;
+      }
+      stream_.put(double_quate);
+      // ダブルクォートは 2 つ続けて書き込む．
+      for(std::size_t i = 0; i < s.size();){
+        auto j = s.find(double_quate, i);
+        if(j == s.npos){
+          stream_.write(s.substr(i));
+          break;
+        }
+        stream_.write(s.substr(i, j + 1 - i));
+        stream_.put(double_quate);
+        i = j + 1;
+      }
+      stream_.put(double_quate);
+    }
+
+    template<class T>
+    void write_number(T value)
+    {
+      auto first = reinterpret_cast<char*>(stream_.prepare(max_number_length));
+      auto [last, ec] = std::to_chars(first, first + max_number_length, value);
+      assert(ec == std::errc()); static_cast<void>(ec);
+      stream_.commit(static_cast<std::size_t>(last - first));
+    }
+
+    // value を width 桁以上になるように 0 で埋めて書き込む．
+    void write_padded(unsigned value, int width)
+    {
+      auto first = reinterpret_cast<char*>(stream_.prepare(max_number_length));
+      auto [last, ec] = std::to_chars(first, first + max_number_length, value);
+      assert(ec == std::errc()); static_cast<void>(ec);
+      auto length = static_cast<int>(last - first);
+      if(length < width){
+        std::memmove(first + (width - length), first, static_cast<std::size_t>(length));
+        std::memset(first, '0', static_cast<std::size_t>(width - length));
+        length = width;
+      }
+      stream_.commit(static_cast<std::size_t>(length));
+    }
+
+  public:
+
+    explicit CSVWriter(OutputStreamT&& stream, char_type delimiter = ','):
+      stream_(std::move(stream)), delimiter_(delimiter), first_field_(true)
+    {}
+
+    CSVWriter(CSVWriter&&) = default;
+
+    /// 処理中のレコードにフィールドを 1 つ書き込む．
+    /// 文字列，文字，整数，浮動小数点数，bool（true/false），Date（YYYY-MM-DD），std::optional（空の場合は空のフィールド）を書き込める．
+    /// note: char と char8_t は数値ではなく文字として書き込む．char_type が 1 バイトの場合，char と char8_t の文字列はどちらも書き込める．
+    template<class T>
+    void write_field(const T& value)
+    {
+      if constexpr(is_optional<T>::value){
+        if(value.has_value()){
+          write_field(*value);
+        }else{
+          start_field();
+        }
+      }else{
+        start_field();
+        if constexpr(std::is_convertible_v<const T&, std::basic_string_view<char_type>>){
+          write_string(value);
+        }else if constexpr(is_byte_string_v<T, char> || is_byte_string_v<T, char8_t>){
+          // note: C++20 では char8_t と char が異なる型なので，"abc" や std::string を char_type の文字列として読み替える．
+          using view_type = std::conditional_t<is_byte_string_v<T, char>, std::string_view, std::basic_string_view<char8_t>>;
+          view_type s(value);
+          write_string(std::basic_string_view<char_type>(reinterpret_cast<const char_type*>(s.data()), s.size()));
+        }else if constexpr(is_character_v<T>){
+          auto c = static_cast<char_type>(value);
+          write_string(std::basic_string_view<char_type>(&c, 1));
+        }else if constexpr(std::is_same_v<T, bool>){
+          static constexpr char_type true_string[] = {'t', 'r', 'u', 'e'};
+          static constexpr char_type false_string[] = {'f', 'a', 'l', 's', 'e'};
+          if(value){
+            stream_.write(true_string, sizeof(true_string));
+          }else{
+            stream_.write(false_string, sizeof(false_string));
+          }
+        }else if constexpr(std::is_arithmetic_v<T>){
+          write_number(value);
+        }else if constexpr(std::is_same_v<T, Date>){
+          if(value.year < 0){
+            stream_.put('-');
+          }
+          write_padded(static_cast<unsigned>(value.year < 0 ? -value.year : value.year), 4);
+          stream_.put('-');
+          write_padded(value.month, 2);
+          stream_.put('-');
+          write_padded(value.day, 2);
+        }else{
+          static_assert(std::is_void_v<T>, "unsupported field type.");
+        }
+      }
+    }
+
+    /// 処理中のレコードを終える．
+    void end_record()
+    {
+      stream_.put(line_feed);
+      first_field_ = true;
+    }
+
+    /// values をフィールドとする 1 つのレコードを書き込む．
+    template<class... Ts>
+    void write_row(const Ts&... values)
+    {
+      (write_field(values), ...);
+      end_record();
+    }
+
+    /// record（CSVRecord 等のフィールドの範囲，または std::tuple）を 1 つのレコードとして書き込む．
+    template<class RecordT>
+    void write_record(const RecordT& record)
+    {
+      if constexpr(is_tuple<RecordT>::value){
+        std::apply([this](const auto&... values){ (write_field(values), ...); }, record);
+      }else{
+        for(auto&& field: record){
+          write_field(field);
+        }
+      }
+      end_record();
+    }
+
+    /// バッファの内容を書き込み，書き込みの完了を待つ．
+    void flush()
+    {
+      stream_.flush();
+    }
+
+    OutputStreamT& stream() noexcept
+    {
+      return stream_;
+    }
+
+  // deleted:
+
+    CSVWriter() = delete;
+    CSVWriter(const CSVWriter&) = delete;
+    CSVWriter& operator=(CSVWriter&&) = delete;
+    CSVWriter& operator=(const CSVWriter&) = delete;
+
+  };
+
+}
+
+
+#endif
@@ -0,0 +1,351 @@
+#ifndef ACCIO_CORE_COROUTINE_HPP_
+#define ACCIO_CORE_COROUTINE_HPP_
+
+
+#include <exception>
+#include <optional>
+#include <utility>
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#define ACCIO_CORE_HAS_COROUTINE
+#endif
+
+
+// note: コルーチンを使う機能（Task, AsyncGenerator, Reactor, AsyncCSVParser 等）は C++20 でコンパイルした場合のみ有効になる．
+// note: Task と AsyncGenerator は，待つ側と待たれる側が同じスレッドで（Reactor 等から）再開されることを前提とする．
+#ifdef ACCIO_CORE_HAS_COROUTINE
+
+
+namespace ACCIO::CORE
+{
+
+  template<class T>
+  class Task;
+
+  namespace detail
+  {
+
+    // 終わったコルーチンから，それを待っているコルーチン（なければ呼び出し元）に制御を移す．
+    struct FinalAwaiter
+    {
+      bool await_ready() const noexcept
+      {
+        return false;
+      }
+
+      template<class PromiseT>
+      std::coroutine_handle<> await_suspend(std::coroutine_handle<PromiseT> handle) const noexcept
+      {
+        auto continuation = handle.promise().continuation_;
+        return continuation ? continuation : std::noop_coroutine();
+      }
+
+      void await_resume() const noexcept
+      {}
+    };
+
+    struct TaskPromiseBase
+    {
+      std::coroutine_handle<> continuation_;
+      std::exception_ptr exception_;
+
+      std::suspend_always initial_suspend() const noexcept
+      {
+        return {};
+      }
+
+      FinalAwaiter final_suspend() const noexcept
+      {
+        return {};
+      }
+
+      void unhandled_exception() noexcept
+      {
+        exception_ = std::current_exception();
+      }
+    };
+
+    template<class T>
+    struct TaskPromise: TaskPromiseBase
+    {
+      std::optional<T> value_;
+
+      Task<T> get_return_object() noexcept;
+
+      template<class U>
+      void return_value(U&& value)
+      {
+        value_.emplace(std::forward<U>(value));
+      }
+
+      T result()
+      {
+        if(exception_ != nullptr) std::rethrow_exception(exception_);
+        return std::move(*value_);
+      }
+    };
+
+    template<>
+    struct TaskPromise<void>: TaskPromiseBase
+    {
+      Task<void> get_return_object() noexcept;
+
+      void return_void() const noexcept
+      {}
+
+      void result()
+      {
+        if(exception_ != nullptr) std::rethrow_exception(exception_);
+      }
+    };
+
+  }
+
+  /// co_await されるまで実行を始めないコルーチン．co_await すると T の値（または送出された例外）が得られる．
+  template<class T = void>
+  class Task
+  {
+  public:
+
+    using promise_type = detail::TaskPromise<T>;
+
+  private:
+
+    std::coroutine_handle<promise_type> handle_;
+
+  public:
+
+    explicit Task(std::coroutine_handle<promise_type> handle) noexcept:
+      handle_(handle)
+    {}
+
+    Task(Task&& other) noexcept:
+      handle_(std::exchange(other.handle_, nullptr))
+    {}
+
+    Task& operator=(Task&& other) noexcept
+    {
+      if(this != &other){
+        if(handle_) handle_.destroy();
+        handle_ = std::exchange(other.handle_, nullptr);
+      }
+      return *this;
+    }
+
+    ~Task()
+    {
+      if(handle_) handle_.destroy();
+    }
+
+    bool done() const noexcept
+    {
+      return !handle_ || handle_.done();
+    }
+
+    /// 待つコルーチンなしで実行を始める（Reactor::spawn() 用）．
+    void start()
+    {
+      handle_.resume();
+    }
+
+    /// 終わったタスクの値を返す．例外が送出されていた場合は再送出する．
+    T result()
+    {
+      return handle_.promise().result();
+    }
+
+    auto operator co_await() && noexcept
+    {
+      struct Awaiter
+      {
+        std::coroutine_handle<promise_type> handle_;
+
+        bool await_ready() const noexcept
+        {
+          return handle_.done();
+        }
+
+        // note: タスクを先に実行し，同期的に終わった場合は中断せずに続ける．continuation_ はタスクが中断した後にのみ設定するので，
+        //       値を待つたびにスタックが深くなることはない（末尾呼び出しの最適化に頼らない）．
+        bool await_suspend(std::coroutine_handle<> continuation) const
+        {
+          handle_.resume();
+          if(handle_.done()) return false;
+          handle_.promise().continuation_ = continuation;
+          return true;
+        }
+
+        T await_resume()
+        {
+          return handle_.promise().result();
+        }
+      };
+      return Awaiter{handle_};
+    }
+
+  // deleted:
+
+    Task() = delete;
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+  };
+
+  namespace detail
+  {
+
+    template<class T>
+    Task<T> TaskPromise<T>::get_return_object() noexcept
+    {
+      return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+    }
+
+    inline Task<void> TaskPromise<void>::get_return_object() noexcept
+    {
+      return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+    }
+
+  }
+
+  /// 値を 1 つずつ非同期に生成するコルーチン．co_await generator.next() で次の値へのポインタ（終わりに達した場合は nullptr）が得られる．
+  /// 値は次に next() を co_await するまで有効である．
+  template<class T>
+  class AsyncGenerator
+  {
+  public:
+
+    struct promise_type
+    {
+      // 中断している間に値を待ち始めたコルーチン．
+      std::coroutine_handle<> continuation_;
+      const T* value_ = nullptr;
+      std::exception_ptr exception_;
+
+      AsyncGenerator get_return_object() noexcept
+      {
+        return AsyncGenerator(std::coroutine_handle<promise_type>::from_promise(*this));
+      }
+
+      std::suspend_always initial_suspend() const noexcept
+      {
+        return {};
+      }
+
+      detail::FinalAwaiter final_suspend() const noexcept
+      {
+        return {};
+      }
+
+      // 値を渡して，待っているコルーチンに制御を移す．
+      auto yield_value(const T& value) noexcept
+      {
+        value_ = &value;
+        struct YieldAwaiter
+        {
+          bool await_ready() const noexcept
+          {
+            return false;
+          }
+
+          std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) const noexcept
+          {
+            auto continuation = std::exchange(handle.promise().continuation_, nullptr);
+            return continuation ? continuation : std::noop_coroutine();
+          }
+
+          void await_resume() const noexcept
+          {}
+        };
+        return YieldAwaiter{};
+      }
+
+      void return_void() noexcept
+      {
+        value_ = nullptr;
+      }
+
+      void unhandled_exception() noexcept
+      {
+        value_ = nullptr;
+        exception_ = std::current_exception();
+      }
+    };
+
+  private:
+
+    std::coroutine_handle<promise_type> handle_;
+
+  public:
+
+    explicit AsyncGenerator(std::coroutine_handle<promise_type> handle) noexcept:
+      handle_(handle)
+    {}
+
+    AsyncGenerator(AsyncGenerator&& other) noexcept:
+      handle_(std::exchange(other.handle_, nullptr))
+    {}
+
+    AsyncGenerator& operator=(AsyncGenerator&& other) noexcept
+    {
+      if(this != &other){
+        if(handle_) handle_.destroy();
+        handle_ = std::exchange(other.handle_, nullptr);
+      }
+      return *this;
+    }
+
+    ~AsyncGenerator()
+    {
+      if(handle_) handle_.destroy();
+    }
+
+    /// 次の値を生成させる．co_await すると，次の値へのポインタか，終わりに達した場合は nullptr が得られる．
+    /// 生成中に例外が送出された場合は，co_await した側に再送出する．
+    /// note: GCC 12 は while の条件式の中の co_await を正しく扱えないので，ループの本体の中で co_await する．
+    auto next() noexcept
+    {
+      struct Awaiter
+      {
+        std::coroutine_handle<promise_type> handle_;
+
+        bool await_ready() const noexcept
+        {
+          return handle_.done();
+        }
+
+        // note: Task と同様に，生成を先に進めて同期的に値が得られた場合は中断しない．
+        bool await_suspend(std::coroutine_handle<> continuation) const
+        {
+          auto& promise = handle_.promise();
+          promise.value_ = nullptr;
+          handle_.resume();
+          if(handle_.done() || promise.value_ != nullptr) return false;
+          promise.continuation_ = continuation;
+          return true;
+        }
+
+        const T* await_resume() const
+        {
+          auto& promise = handle_.promise();
+          if(promise.exception_ != nullptr) std::rethrow_exception(std::exchange(promise.exception_, nullptr));
+          return handle_.done() ? nullptr : promise.value_;
+        }
+      };
+      return Awaiter{handle_};
+    }
+
+  // deleted:
+
+    AsyncGenerator() = delete;
+    AsyncGenerator(const AsyncGenerator&) = delete;
+    AsyncGenerator& operator=(const AsyncGenerator&) = delete;
+
+  };
+
+}
+
+
+#endif
+
+
+#endif
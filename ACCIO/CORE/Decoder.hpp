@@ -16,6 +16,10 @@ namespace ACCIO::CORE
     std::enable_if_t<std::is_same_v<CharT, char8_t>>* = nullptr>
   std::unique_ptr<Reader<CharT>> make_decoder(std::shared_ptr<BinaryReader>& binary_reader, const std::string& encoding);
 
+  /// [s, s + n) が encoding の文字列として妥当であることを検証し，妥当でなければ例外を送出する．
+  /// note: [s, s + n) は文字の境界で区切られている必要がある．
+  void validate_encoding(const char* s, std::size_t n, const std::string& encoding);
+
 }
 
 
@@ -0,0 +1,736 @@
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+#include "DecompressingReader.hpp"
+#if __has_include(<zstd.h>)
+#include <zstd.h>
+#include <zstd_errors.h>
+#define ACCIO_CORE_HAS_ZSTD
+#endif
+#if __has_include(<lz4frame.h>)
+#include <lz4frame.h>
+#define ACCIO_CORE_HAS_LZ4
+#endif
+
+
+namespace ACCIO::CORE
+{
+
+  namespace
+  {
+
+    // 読み込み元から受け取った，まだ展開していないデータ．
+    // note: 読み込み元が mappable な場合はその領域を直接参照し，コピーしない．
+    class InputBuffer
+    {
+    private:
+
+      std::unique_ptr<BinaryReader> binary_reader_;
+      std::size_t chunk_size_;
+      std::unique_ptr<char[]> buffer_;
+      std::size_t buffer_size_;
+      const char* first_;
+      const char* last_;
+      // ensure() で集めたデータと，その時点で受け取っていた領域の残り．
+      // note: ムーブしても領域が移動しないように std::vector を用いる．
+      std::vector<char> head_;
+      const char* rest_first_;
+      const char* rest_last_;
+
+    public:
+
+      explicit InputBuffer(std::unique_ptr<BinaryReader>&& binary_reader):
+        binary_reader_(std::move(binary_reader)), chunk_size_(std::max<std::size_t>(binary_reader_->preferred_buffer_size(), 1 << 16)),
+        buffer_(), buffer_size_(0), first_(nullptr), last_(nullptr), head_(), rest_first_(nullptr), rest_last_(nullptr)
+      {}
+
+      InputBuffer(InputBuffer&&) = default;
+
+      std::size_t chunk_size() const noexcept
+      {
+        return chunk_size_;
+      }
+
+      const char* data() const noexcept
+      {
+        return first_;
+      }
+
+      std::size_t size() const noexcept
+      {
+        return static_cast<std::size_t>(last_ - first_);
+      }
+
+      void consume(std::size_t n) noexcept
+      {
+        assert(n <= size());
+        first_ += n;
+      }
+
+      /// 残りを読み切った場合に次の領域を受け取る．EOF の場合は false を返す．
+      bool fill()
+      {
+        if(first_ != last_) return true;
+        if(rest_first_ != rest_last_){
+          first_ = rest_first_;
+          last_ = rest_last_;
+          rest_first_ = rest_last_ = nullptr;
+          return true;
+        }
+        if(binary_reader_ == nullptr) return false;
+        if(binary_reader_->mappable()){
+          auto [first, n] = binary_reader_->map(chunk_size_);
+          first_ = first;
+          last_ = first + n;
+        }else{
+          if(buffer_ == nullptr){
+            buffer_size_ = std::max(chunk_size_, binary_reader_->min_buffer_size());
+            buffer_ = std::make_unique<char[]>(buffer_size_);
+          }
+          auto n = (*binary_reader_)(buffer_.get(), buffer_size_);
+          first_ = buffer_.get();
+          last_ = first_ + n;
+        }
+        return first_ != last_;
+      }
+
+      /// EOF でなければ，少なくとも n バイトを data() から参照できるようにする．
+      void ensure(std::size_t n)
+      {
+        fill();
+        if(size() >= n || first_ == last_) return;
+        // note: 短い読み込みが続いた場合は head_ に集め，受け取った領域の残りは head_ を読み切った後に返す．
+        // 残りが head_ 自身を参照している場合があるので，新しい領域に集める．
+        std::vector<char> head(first_, last_);
+        head.reserve(n);
+        first_ = last_;
+        while(head.size() < n && fill()){
+          auto m = std::min(n - head.size(), size());
+          head.insert(head.end(), first_, first_ + m);
+          first_ += m;
+        }
+        rest_first_ = first_;
+        rest_last_ = last_;
+        head_ = std::move(head);
+        first_ = head_.data();
+        last_ = first_ + head_.size();
+      }
+
+      void close() noexcept
+      {
+        if(binary_reader_ != nullptr){
+          binary_reader_->close();
+          binary_reader_ = nullptr;
+        }
+        first_ = last_ = nullptr;
+        rest_first_ = rest_last_ = nullptr;
+      }
+
+    };
+
+
+    // 圧縮されていないデータをそのまま返す．
+    class BinaryPassThroughReader final: public BinaryReader
+    {
+    private:
+
+      InputBuffer input_;
+
+    public:
+
+      explicit BinaryPassThroughReader(InputBuffer&& input):
+        input_(std::move(input))
+      {}
+
+      std::size_t min_buffer_size() const noexcept override
+      {
+        return 1;
+      }
+
+      std::size_t preferred_buffer_size() const noexcept override
+      {
+        return input_.chunk_size();
+      }
+
+      std::size_t operator()(char* buffer, std::size_t limit) override
+      {
+        if(!input_.fill()) return 0;
+        auto n = std::min(limit, input_.size());
+        std::memcpy(buffer, input_.data(), n);
+        input_.consume(n);
+        return n;
+      }
+
+      bool mappable() const noexcept override
+      {
+        return true;
+      }
+
+      std::tuple<const char*, std::size_t> map(std::size_t limit) override
+      {
+        if(!input_.fill()) return {nullptr, 0};
+        auto n = std::min(limit, input_.size());
+        const char* result = input_.data();
+        input_.consume(n);
+        return {result, n};
+      }
+
+      void close() noexcept override
+      {
+        input_.close();
+      }
+
+    };
+
+    // note: 展開後のデータは圧縮前より大きいので，読み込み元より大きなバッファで読み込むほうが効率がよい．
+    constexpr std::size_t preferred_output_size = 1 << 20;
+
+    class BinaryGzipReader final: public BinaryReader
+    {
+    private:
+
+      InputBuffer input_;
+      z_stream stream_;
+      bool initialized_;
+      // メンバの終わりまで展開したか．
+      bool member_end_;
+
+    public:
+
+      explicit BinaryGzipReader(InputBuffer&& input):
+        input_(std::move(input)), stream_(), initialized_(false), member_end_(false)
+      {
+        // note: 15 + 32 は最大の窓の大きさで，gzip と zlib のヘッダを自動で判別することを表す．
+        if(::inflateInit2(&stream_, 15 + 32) != Z_OK) throw std::runtime_error("inflateInit2() failure.");
+        initialized_ = true;
+      }
+
+      ~BinaryGzipReader() noexcept
+      {
+        close();
+      }
+
+      std::size_t min_buffer_size() const noexcept override
+      {
+        return 1;
+      }
+
+      std::size_t preferred_buffer_size() const noexcept override
+      {
+        return preferred_output_size;
+      }
+
+      std::size_t operator()(char* buffer, std::size_t limit) override
+      {
+        if(!initialized_) return 0;
+        stream_.next_out = reinterpret_cast<Bytef*>(buffer);
+        stream_.avail_out = static_cast<uInt>(std::min<std::size_t>(limit, UINT_MAX));
+        auto avail_out = stream_.avail_out;
+        while(stream_.avail_out > 0){
+          if(!input_.fill()){
+            if(!member_end_) throw std::runtime_error("unexpected EOF");
+            break;
+          }
+          if(member_end_){
+            // 連結された次のメンバを展開する．
+            if(::inflateReset(&stream_) != Z_OK) throw std::runtime_error("inflate() failure.");
+            member_end_ = false;
+          }
+          stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input_.data()));
+          stream_.avail_in = static_cast<uInt>(std::min<std::size_t>(input_.size(), UINT_MAX));
+          auto avail_in = stream_.avail_in;
+          auto ret = ::inflate(&stream_, Z_NO_FLUSH);
+          input_.consume(avail_in - stream_.avail_in);
+          if(ret == Z_STREAM_END){
+            member_end_ = true;
+          }else if(ret != Z_OK){
+            throw std::runtime_error("inflate() failure.");
+          }
+        }
+        return avail_out - stream_.avail_out;
+      }
+
+      void close() noexcept override
+      {
+        if(initialized_){
+          ::inflateEnd(&stream_);
+          initialized_ = false;
+        }
+        input_.close();
+      }
+
+    // deleted:
+
+      BinaryGzipReader(BinaryGzipReader&&) = delete;
+      BinaryGzipReader(const BinaryGzipReader&) = delete;
+      BinaryGzipReader& operator=(BinaryGzipReader&&) = delete;
+      BinaryGzipReader& operator=(const BinaryGzipReader&) = delete;
+
+    };
+
+#ifdef ACCIO_CORE_HAS_ZSTD
+    class BinaryZstdReader final: public BinaryReader
+    {
+    private:
+
+      InputBuffer input_;
+      ZSTD_DCtx* context_;
+      // 最後の ZSTD_decompressStream() の戻り値．0 はフレームの終わりまで展開したことを表す．
+      std::size_t hint_;
+
+    public:
+
+      explicit BinaryZstdReader(InputBuffer&& input):
+        input_(std::move(input)), context_(::ZSTD_createDCtx()), hint_(0)
+      {
+        if(context_ == nullptr) throw std::runtime_error("ZSTD_createDCtx() failure.");
+      }
+
+      ~BinaryZstdReader() noexcept
+      {
+        close();
+      }
+
+      std::size_t min_buffer_size() const noexcept override
+      {
+        return 1;
+      }
+
+      std::size_t preferred_buffer_size() const noexcept override
+      {
+        return std::max(preferred_output_size, ::ZSTD_DStreamOutSize());
+      }
+
+      std::size_t operator()(char* buffer, std::size_t limit) override
+      {
+        if(context_ == nullptr) return 0;
+        ZSTD_outBuffer output{buffer, limit, 0};
+        while(output.pos < output.size){
+          if(!input_.fill()){
+            if(hint_ != 0) throw std::runtime_error("unexpected EOF");
+            break;
+          }
+          // note: 連結された複数のフレームは続けて展開される．
+          ZSTD_inBuffer in{input_.data(), input_.size(), 0};
+          auto ret = ::ZSTD_decompressStream(context_, &output, &in);
+          input_.consume(in.pos);
+          if(::ZSTD_isError(ret)) throw std::runtime_error("ZSTD_decompressStream() failure.");
+          hint_ = ret;
+        }
+        return output.pos;
+      }
+
+      void close() noexcept override
+      {
+        if(context_ != nullptr){
+          ::ZSTD_freeDCtx(context_);
+          context_ = nullptr;
+        }
+        input_.close();
+      }
+
+    // deleted:
+
+      BinaryZstdReader(BinaryZstdReader&&) = delete;
+      BinaryZstdReader(const BinaryZstdReader&) = delete;
+      BinaryZstdReader& operator=(BinaryZstdReader&&) = delete;
+      BinaryZstdReader& operator=(const BinaryZstdReader&) = delete;
+
+    };
+
+    // フレームヘッダの最大の大きさ（ZSTD_FRAMEHEADERSIZE_MAX は ZSTD_STATIC_LINKING_ONLY でのみ定義される）．
+    constexpr std::size_t zstd_frame_header_size_max = 18;
+    // 先頭のフレームを展開した大きさがこれ以下であれば，フレームごとに並行に展開する．
+    constexpr unsigned long long max_parallel_frame_size = 64 << 20;
+
+    // 複数のフレームからなる zstd 形式（pzstd の出力等）を，フレームごとに複数のスレッドで並行に展開する．
+    // note: 呼び出し元のスレッドはフレームの境界を求めて圧縮されたフレームを写すだけとし，展開はワーカーに任せる．
+    // 展開したフレームはファイルの順に返す．展開を待つフレームは最大 window_ 個とする．
+    class BinaryParallelZstdReader final: public BinaryReader
+    {
+    private:
+
+      struct Job
+      {
+        std::vector<char> input_;
+        std::vector<char> output_;
+        // output_ のうち展開した部分の大きさ．
+        std::size_t size_;
+        bool done_;
+        std::exception_ptr exception_;
+      };
+
+      InputBuffer input_;
+      std::size_t window_;
+      // 展開を依頼したフレーム（ファイルの順）．先頭は返している途中のフレームである．
+      // note: std::deque は両端に追加・削除しても他の要素が移動しないので，ワーカーは要素を直接参照する．
+      std::deque<Job> jobs_;
+      // 展開を待っているフレーム．
+      std::deque<Job*> pending_;
+      // 返し終えたフレーム．次のフレームで領域を再利用する．
+      std::vector<Job> spares_;
+      std::mutex mutex_;
+      std::condition_variable condition_;
+      bool stop_;
+      bool eof_;
+      // 先頭のフレームのうち返した部分の大きさ．
+      std::size_t position_;
+      std::vector<std::thread> threads_;
+
+      static void decompress(ZSTD_DCtx* context, Job& job)
+      {
+        auto content_size = ::ZSTD_getFrameContentSize(job.input_.data(), job.input_.size());
+        if(content_size == ZSTD_CONTENTSIZE_ERROR) throw std::runtime_error("ZSTD_getFrameContentSize() failure.");
+        if(content_size != ZSTD_CONTENTSIZE_UNKNOWN){
+          if(job.output_.size() < content_size) job.output_.resize(content_size);
+          auto ret = ::ZSTD_decompressDCtx(context, job.output_.data(), content_size, job.input_.data(), job.input_.size());
+          if(::ZSTD_isError(ret)) throw std::runtime_error("ZSTD_decompressDCtx() failure.");
+          job.size_ = ret;
+          return;
+        }
+        // 展開した大きさがフレームヘッダにない場合は，領域を広げながら展開する．
+        ::ZSTD_DCtx_reset(context, ZSTD_reset_session_only);
+        ZSTD_inBuffer in{job.input_.data(), job.input_.size(), 0};
+        job.size_ = 0;
+        while(true){
+          if(job.output_.size() - job.size_ < ::ZSTD_DStreamOutSize()){
+            job.output_.resize(std::max(job.output_.size() * 2, job.size_ + ::ZSTD_DStreamOutSize()));
+          }
+          ZSTD_outBuffer out{job.output_.data(), job.output_.size(), job.size_};
+          auto ret = ::ZSTD_decompressStream(context, &out, &in);
+          if(::ZSTD_isError(ret)) throw std::runtime_error("ZSTD_decompressStream() failure.");
+          job.size_ = out.pos;
+          if(ret == 0) break;
+          if(in.pos == in.size && out.pos < out.size) throw std::runtime_error("unexpected EOF");
+        }
+      }
+
+      void run() noexcept
+      {
+        auto context = ::ZSTD_createDCtx();
+        while(true){
+          Job* job;
+          {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this]{ return stop_ || !pending_.empty(); });
+            if(stop_) break;
+            job = pending_.front();
+            pending_.pop_front();
+          }
+          std::exception_ptr exception;
+          try{
+            if(context == nullptr) throw std::runtime_error("ZSTD_createDCtx() failure.");
+            decompress(context, *job);
+          }catch(...){
+            exception = std::current_exception();
+          }
+          std::lock_guard<std::mutex> lock(mutex_);
+          job->exception_ = exception;
+          job->done_ = true;
+          condition_.notify_all();
+        }
+        ::ZSTD_freeDCtx(context);
+      }
+
+      // 次のフレームを frame に写す．EOF の場合は false を返す．
+      bool next_frame(std::vector<char>& frame)
+      {
+        if(!input_.fill()) return false;
+        while(true){
+          auto size = ::ZSTD_findFrameCompressedSize(input_.data(), input_.size());
+          if(!::ZSTD_isError(size)){
+            frame.assign(input_.data(), input_.data() + size);
+            input_.consume(size);
+            return true;
+          }
+          if(::ZSTD_getErrorCode(size) != ZSTD_error_srcSize_wrong) throw std::runtime_error("ZSTD_findFrameCompressedSize() failure.");
+          // 受け取った領域がフレームの途中で終わっているので，続きと合わせて参照できるようにする．
+          auto available = input_.size();
+          input_.ensure(std::max(available * 2, input_.chunk_size()));
+          if(input_.size() == available) throw std::runtime_error("unexpected EOF");
+        }
+      }
+
+      // 展開を依頼したフレームが window_ 個になるまで，次のフレームをワーカーに渡す．
+      void schedule()
+      {
+        while(!eof_ && jobs_.size() < window_){
+          Job job{};
+          if(!spares_.empty()){
+            job = std::move(spares_.back());
+            spares_.pop_back();
+          }
+          if(!next_frame(job.input_)){
+            eof_ = true;
+            break;
+          }
+          job.size_ = 0;
+          job.done_ = false;
+          job.exception_ = nullptr;
+          std::lock_guard<std::mutex> lock(mutex_);
+          jobs_.push_back(std::move(job));
+          pending_.push_back(&jobs_.back());
+          condition_.notify_one();
+        }
+      }
+
+    public:
+
+      BinaryParallelZstdReader(InputBuffer&& input, std::size_t threads):
+        input_(std::move(input)), window_(2 * threads), jobs_(), pending_(), spares_(), mutex_(), condition_(),
+        stop_(false), eof_(false), position_(0), threads_()
+      {
+        try{
+          for(std::size_t i = 0; i < threads; ++i){
+            threads_.emplace_back([this]{ run(); });
+          }
+        }catch(...){
+          close();
+          throw;
+        }
+      }
+
+      ~BinaryParallelZstdReader() noexcept
+      {
+        close();
+      }
+
+      std::size_t min_buffer_size() const noexcept override
+      {
+        return 1;
+      }
+
+      std::size_t preferred_buffer_size() const noexcept override
+      {
+        return preferred_output_size;
+      }
+
+      std::size_t operator()(char* buffer, std::size_t limit) override
+      {
+        auto [first, n] = map(limit);
+        std::memcpy(buffer, first, n);
+        return n;
+      }
+
+      bool mappable() const noexcept override
+      {
+        return true;
+      }
+
+      std::tuple<const char*, std::size_t> map(std::size_t limit) override
+      {
+        while(true){
+          schedule();
+          if(jobs_.empty()) return {nullptr, 0};
+          auto& job = jobs_.front();
+          {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [&]{ return job.done_; });
+          }
+          if(job.exception_ != nullptr) std::rethrow_exception(job.exception_);
+          if(position_ < job.size_){
+            auto n = std::min(limit, job.size_ - position_);
+            const char* result = job.output_.data() + position_;
+            position_ += n;
+            return {result, n};
+          }
+          // 返し終えたフレームの領域は，前に返した領域が無効になるこの時点で再利用に回す．
+          spares_.push_back(std::move(job));
+          {
+            std::lock_guard<std::mutex> lock(mutex_);
+            jobs_.pop_front();
+          }
+          position_ = 0;
+        }
+      }
+
+      void close() noexcept override
+      {
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          stop_ = true;
+          condition_.notify_all();
+        }
+        for(auto&& thread: threads_){
+          thread.join();
+        }
+        threads_.clear();
+        pending_.clear();
+        jobs_.clear();
+        spares_.clear();
+        eof_ = true;
+        input_.close();
+      }
+
+    // deleted:
+
+      BinaryParallelZstdReader(BinaryParallelZstdReader&&) = delete;
+      BinaryParallelZstdReader(const BinaryParallelZstdReader&) = delete;
+      BinaryParallelZstdReader& operator=(BinaryParallelZstdReader&&) = delete;
+      BinaryParallelZstdReader& operator=(const BinaryParallelZstdReader&) = delete;
+
+    };
+#endif
+
+#ifdef ACCIO_CORE_HAS_LZ4
+    class BinaryLz4Reader final: public BinaryReader
+    {
+    private:
+
+      InputBuffer input_;
+      LZ4F_dctx* context_;
+      // 最後の LZ4F_decompress() の戻り値．0 はフレームの終わりまで展開したことを表す．
+      std::size_t hint_;
+
+    public:
+
+      explicit BinaryLz4Reader(InputBuffer&& input):
+        input_(std::move(input)), context_(nullptr), hint_(0)
+      {
+        if(::LZ4F_isError(::LZ4F_createDecompressionContext(&context_, LZ4F_VERSION))){
+          throw std::runtime_error("LZ4F_createDecompressionContext() failure.");
+        }
+      }
+
+      ~BinaryLz4Reader() noexcept
+      {
+        close();
+      }
+
+      std::size_t min_buffer_size() const noexcept override
+      {
+        return 1;
+      }
+
+      std::size_t preferred_buffer_size() const noexcept override
+      {
+        return preferred_output_size;
+      }
+
+      std::size_t operator()(char* buffer, std::size_t limit) override
+      {
+        if(context_ == nullptr) return 0;
+        std::size_t n = 0;
+        while(n < limit){
+          if(!input_.fill()){
+            if(hint_ != 0) throw std::runtime_error("unexpected EOF");
+            break;
+          }
+          auto output_size = limit - n;
+          auto input_size = input_.size();
+          // note: フレームの終わりまで展開すると，次のフレームから続けて展開できる．
+          auto ret = ::LZ4F_decompress(context_, buffer + n, &output_size, input_.data(), &input_size, nullptr);
+          input_.consume(input_size);
+          if(::LZ4F_isError(ret)) throw std::runtime_error("LZ4F_decompress() failure.");
+          n += output_size;
+          hint_ = ret;
+        }
+        return n;
+      }
+
+      void close() noexcept override
+      {
+        if(context_ != nullptr){
+          ::LZ4F_freeDecompressionContext(context_);
+          context_ = nullptr;
+        }
+        input_.close();
+      }
+
+    // deleted:
+
+      BinaryLz4Reader(BinaryLz4Reader&&) = delete;
+      BinaryLz4Reader(const BinaryLz4Reader&) = delete;
+      BinaryLz4Reader& operator=(BinaryLz4Reader&&) = delete;
+      BinaryLz4Reader& operator=(const BinaryLz4Reader&) = delete;
+
+    };
+#endif
+
+    std::unique_ptr<BinaryReader> make_gzip_reader(InputBuffer&& input)
+    {
+      return std::make_unique<BinaryGzipReader>(std::move(input));
+    }
+
+    std::unique_ptr<BinaryReader> make_zstd_reader(InputBuffer&& input, std::size_t threads)
+    {
+#ifdef ACCIO_CORE_HAS_ZSTD
+      if(threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+      if(threads > 1){
+        // note: zstd コマンドは既定ではファイル全体を 1 つのフレームとするので，先頭のフレームが十分に小さい場合のみ並行に展開する．
+        input.ensure(zstd_frame_header_size_max);
+        if(::ZSTD_getFrameContentSize(input.data(), input.size()) <= max_parallel_frame_size){
+          return std::make_unique<BinaryParallelZstdReader>(std::move(input), threads);
+        }
+      }
+      return std::make_unique<BinaryZstdReader>(std::move(input));
+#else
+      static_cast<void>(input);
+      static_cast<void>(threads);
+      throw std::runtime_error("zstd input is not supported (built without zstd.h).");
+#endif
+    }
+
+    std::unique_ptr<BinaryReader> make_lz4_reader(InputBuffer&& input)
+    {
+#ifdef ACCIO_CORE_HAS_LZ4
+      return std::make_unique<BinaryLz4Reader>(std::move(input));
+#else
+      static_cast<void>(input);
+      throw std::runtime_error("lz4 input is not supported (built without lz4frame.h).");
+#endif
+    }
+
+    template<std::size_t N>
+    bool starts_with(const InputBuffer& input, const unsigned char (&magic)[N]) noexcept
+    {
+      return input.size() >= N && std::memcmp(input.data(), magic, N) == 0;
+    }
+
+  }
+
+  std::unique_ptr<BinaryReader> make_binary_decompressing_reader(std::unique_ptr<BinaryReader>&& binary_reader, std::size_t threads)
+  {
+    // note: gzip は 2 バイトのマジックナンバーの後に圧縮方式（8: deflate）が続く．
+    static constexpr unsigned char gzip_magic[3] = {0x1f, 0x8b, 0x08};
+    static constexpr unsigned char zstd_magic[4] = {0x28, 0xb5, 0x2f, 0xfd};
+    static constexpr unsigned char lz4_magic[4] = {0x04, 0x22, 0x4d, 0x18};
+    InputBuffer input(std::move(binary_reader));
+    input.ensure(4);
+    if(starts_with(input, gzip_magic)){
+      return make_gzip_reader(std::move(input));
+    }else if(starts_with(input, zstd_magic)){
+      return make_zstd_reader(std::move(input), threads);
+    }else if(starts_with(input, lz4_magic)){
+      return make_lz4_reader(std::move(input));
+    }else{
+      return std::make_unique<BinaryPassThroughReader>(std::move(input));
+    }
+  }
+
+  std::unique_ptr<BinaryReader> make_binary_gzip_reader(std::unique_ptr<BinaryReader>&& binary_reader)
+  {
+    return make_gzip_reader(InputBuffer(std::move(binary_reader)));
+  }
+
+  std::unique_ptr<BinaryReader> make_binary_zstd_reader(std::unique_ptr<BinaryReader>&& binary_reader, std::size_t threads)
+  {
+    return make_zstd_reader(InputBuffer(std::move(binary_reader)), threads);
+  }
+
+  std::unique_ptr<BinaryReader> make_binary_lz4_reader(std::unique_ptr<BinaryReader>&& binary_reader)
+  {
+    return make_lz4_reader(InputBuffer(std::move(binary_reader)));
+  }
+
+}
@@ -0,0 +1,31 @@
+#ifndef ACCIO_CORE_DECOMPRESSINGREADER_HPP_
+#define ACCIO_CORE_DECOMPRESSINGREADER_HPP_
+
+
+#include "Reader.hpp"
+
+
+// note: gzip は zlib を用いる（-lz）．zstd（-lzstd）と lz4（-llz4）はヘッダがある環境でのみ有効となり，無効な場合はその形式の入力に対して，対応していない旨の std::runtime_error を送出する．
+
+
+namespace ACCIO::CORE
+{
+
+  /// binary_reader の先頭のマジックナンバーから圧縮形式（gzip, zstd, lz4）を判定し，展開しながら読み込む BinaryReader を作成する．
+  /// 圧縮されていない場合はそのまま読み込む．threads は make_binary_zstd_reader() と同じである．
+  std::unique_ptr<BinaryReader> make_binary_decompressing_reader(std::unique_ptr<BinaryReader>&& binary_reader, std::size_t threads = 1);
+
+  /// gzip 形式（連結された複数のメンバを含む）を展開しながら読み込む BinaryReader を作成する．
+  std::unique_ptr<BinaryReader> make_binary_gzip_reader(std::unique_ptr<BinaryReader>&& binary_reader);
+
+  /// zstd 形式（複数のフレームを含む）を展開しながら読み込む BinaryReader を作成する．
+  /// threads が 2 以上（0 の場合はハードウェアのスレッド数）で先頭のフレームが小さい場合は，複数のフレームを threads 個のスレッドで並行に展開する．
+  std::unique_ptr<BinaryReader> make_binary_zstd_reader(std::unique_ptr<BinaryReader>&& binary_reader, std::size_t threads = 1);
+
+  /// lz4 フレーム形式（複数のフレームを含む）を展開しながら読み込む BinaryReader を作成する．
+  std::unique_ptr<BinaryReader> make_binary_lz4_reader(std::unique_ptr<BinaryReader>&& binary_reader);
+
+}
+
+
+#endif
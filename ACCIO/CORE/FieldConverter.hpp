@@ -0,0 +1,279 @@
+#ifndef ACCIO_CORE_FIELDCONVERTER_HPP_
+#define ACCIO_CORE_FIELDCONVERTER_HPP_
+
+
+#include <cassert>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include "char8_t.hpp"
+
+
+namespace ACCIO::CORE
+{
+
+  /// "YYYY-MM-DD" 形式の日付．
+  struct Date
+  {
+    int year;
+    unsigned month;
+    unsigned day;
+
+    bool operator==(const Date& rhs) const noexcept
+    {
+      return year == rhs.year && month == rhs.month && day == rhs.day;
+    }
+
+    bool operator!=(const Date& rhs) const noexcept
+    {
+      return !operator==(rhs);
+    }
+
+  };
+
+  /// フィールドの文字列を T に変換する．変換できない場合は例外を送出する．
+  /// note: 特殊化を追加すれば CSVRecord::get() や Schema で任意の型を扱える．
+  template<class T, class = void>
+  struct FieldConverter;
+
+  namespace DETAIL
+  {
+
+    template<class CharT>
+    [[noreturn]] inline void throw_conversion_error(std::basic_string_view<CharT> field)
+    {
+      if constexpr(sizeof(CharT) == 1){
+        throw std::runtime_error("cannot convert \"" + std::string(reinterpret_cast<const char*>(field.data()), field.size()) + "\".");
+      }else{
+        throw std::runtime_error("cannot convert.");
+      }
+    }
+
+    // s が 8 桁の数字であれば，その値を value に格納して true を返す．
+    // note: 8 バイトを 1 つの 64 ビット整数として扱い，乗算 3 回で 8 桁をまとめて変換する（SWAR）．
+    inline bool parse_eight_digits(const char* s, std::uint64_t& value) noexcept
+    {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+      std::uint64_t v;
+      std::memcpy(&v, s, 8);
+      // '0' から '9' 以外のバイトを含むかを調べる．
+      if(((v & 0xF0F0F0F0F0F0F0F0) | (((v + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) != 0x3333333333333333) return false;
+      v -= 0x3030303030303030;
+      v = v * 10 + (v >> 8);
+      value = (((v & 0x000000FF000000FF) * (100 + (1000000ULL << 32))) + (((v >> 16) & 0x000000FF000000FF) * (1 + (10000ULL << 32)))) >> 32;
+      return true;
+#else
+      value = 0;
+      for(int i = 0; i < 8; ++i){
+        if(s[i] < '0' || '9' < s[i]) return false;
+        value = value * 10 + static_cast<std::uint64_t>(s[i] - '0');
+      }
+      return true;
+#endif
+    }
+
+    // [s, s + n) を符号なしの 10 進数として読む．19 桁までなら桁あふれしない．
+    inline bool parse_digits(const char* s, std::size_t n, std::uint64_t& value) noexcept
+    {
+      assert(n <= 19);
+      std::uint64_t result = 0;
+      std::size_t i = 0;
+      for(; i + 8 <= n; i += 8){
+        std::uint64_t block;
+        if(!parse_eight_digits(s + i, block)) return false;
+        result = result * 100000000 + block;
+      }
+      for(; i < n; ++i){
+        if(s[i] < '0' || '9' < s[i]) return false;
+        result = result * 10 + static_cast<std::uint64_t>(s[i] - '0');
+      }
+      value = result;
+      return true;
+    }
+
+    template<class T>
+    std::optional<T> parse_integer(const char* s, std::size_t n) noexcept
+    {
+      bool negative = std::is_signed_v<T> && n != 0 && s[0] == '-';
+      std::size_t digits = n - (negative ? 1 : 0);
+      if(digits == 0) return std::nullopt;
+      if(digits <= 19){
+        std::uint64_t magnitude;
+        if(!parse_digits(s + (negative ? 1 : 0), digits, magnitude)) return std::nullopt;
+        if(negative){
+          if(magnitude > static_cast<std::uint64_t>(std::numeric_limits<T>::max()) + 1) return std::nullopt;
+          return static_cast<T>(0 - magnitude);
+        }else{
+          if(magnitude > static_cast<std::uint64_t>(std::numeric_limits<T>::max())) return std::nullopt;
+          return static_cast<T>(magnitude);
+        }
+      }
+      // 長い数字列（先頭に 0 が続く場合など）は std::from_chars に任せる．
+      T value;
+      auto [last, error] = std::from_chars(s, s + n, value);
+      if(error != std::errc() || last != s + n) return std::nullopt;
+      return value;
+    }
+
+    inline bool is_leap_year(int year) noexcept
+    {
+      return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    }
+
+  }
+
+  template<class T>
+  struct FieldConverter<T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>>
+  {
+    template<class CharT>
+    static T convert(std::basic_string_view<CharT> field)
+    {
+      static_assert(sizeof(CharT) == 1);
+      auto value = DETAIL::parse_integer<T>(reinterpret_cast<const char*>(field.data()), field.size());
+      if(!value) DETAIL::throw_conversion_error(field);
+      return *value;
+    }
+  };
+
+  template<class T>
+  struct FieldConverter<T, std::enable_if_t<std::is_floating_point_v<T>>>
+  {
+    template<class CharT>
+    static T convert(std::basic_string_view<CharT> field)
+    {
+      static_assert(sizeof(CharT) == 1);
+      auto first = reinterpret_cast<const char*>(field.data());
+      T value;
+      auto [last, error] = std::from_chars(first, first + field.size(), value);
+      if(error != std::errc() || last != first + field.size()) DETAIL::throw_conversion_error(field);
+      return value;
+    }
+  };
+
+  template<>
+  struct FieldConverter<bool>
+  {
+    template<class CharT>
+    static bool convert(std::basic_string_view<CharT> field)
+    {
+      if(field.size() == 1 && field[0] == '1') return true;
+      if(field.size() == 1 && field[0] == '0') return false;
+      static constexpr CharT true_text[] = {'t', 'r', 'u', 'e'};
+      static constexpr CharT false_text[] = {'f', 'a', 'l', 's', 'e'};
+      if(field == std::basic_string_view<CharT>(true_text, 4)) return true;
+      if(field == std::basic_string_view<CharT>(false_text, 5)) return false;
+      DETAIL::throw_conversion_error(field);
+    }
+  };
+
+  template<>
+  struct FieldConverter<Date>
+  {
+    template<class CharT>
+    static Date convert(std::basic_string_view<CharT> field)
+    {
+      static_assert(sizeof(CharT) == 1);
+      auto s = reinterpret_cast<const char*>(field.data());
+      std::uint64_t year, month, day;
+      if(field.size() != 10 || s[4] != '-' || s[7] != '-' ||
+         !DETAIL::parse_digits(s, 4, year) || !DETAIL::parse_digits(s + 5, 2, month) || !DETAIL::parse_digits(s + 8, 2, day)){
+        DETAIL::throw_conversion_error(field);
+      }
+      static constexpr unsigned days_in_month[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+      if(month < 1 || 12 < month || day < 1 ||
+         day > days_in_month[month - 1] + (month == 2 && DETAIL::is_leap_year(static_cast<int>(year)) ? 1 : 0)){
+        DETAIL::throw_conversion_error(field);
+      }
+      return {static_cast<int>(year), static_cast<unsigned>(month), static_cast<unsigned>(day)};
+    }
+  };
+
+  /// 文字列のビューは変換せずに返す．フィールドと同じく次のレコードを読むまで有効である．
+  template<class CharT>
+  struct FieldConverter<std::basic_string_view<CharT>>
+  {
+    static std::basic_string_view<CharT> convert(std::basic_string_view<CharT> field) noexcept
+    {
+      return field;
+    }
+  };
+
+  template<class CharT>
+  struct FieldConverter<std::basic_string<CharT>>
+  {
+    static std::basic_string<CharT> convert(std::basic_string_view<CharT> field)
+    {
+      return std::basic_string<CharT>(field);
+    }
+  };
+
+  /// 空のフィールドを std::nullopt とする．
+  template<class T>
+  struct FieldConverter<std::optional<T>>
+  {
+    template<class CharT>
+    static std::optional<T> convert(std::basic_string_view<CharT> field)
+    {
+      if(field.empty()) return std::nullopt;
+      return FieldConverter<T>::convert(field);
+    }
+  };
+
+  /// レコードの先頭から順に Ts... 型として読むスキーマ．
+  /// 余分なフィールドは無視し，フィールドが足りない場合は例外を送出する．
+  template<class... Ts>
+  struct Schema
+  {
+    using tuple_type = std::tuple<Ts...>;
+
+    static constexpr std::size_t size = sizeof...(Ts);
+
+    template<class RecordT>
+    static tuple_type convert(const RecordT& record)
+    {
+      if(record.size() < size) throw std::runtime_error("too few fields.");
+      return convert(record, std::index_sequence_for<Ts...>());
+    }
+
+    /// 変換した値で T を集成体初期化する．
+    template<class T, class RecordT>
+    static T make(const RecordT& record)
+    {
+      if(record.size() < size) throw std::runtime_error("too few fields.");
+      return make<T>(record, std::index_sequence_for<Ts...>());
+    }
+
+  private:
+
+    template<class RecordT, std::size_t... Is>
+    static tuple_type convert(const RecordT& record, std::index_sequence<Is...>)
+    {
+      // note: 波括弧による初期化なので，フィールドは先頭から順に変換される．
+      return tuple_type{FieldConverter<Ts>::convert(record[Is])...};
+    }
+
+    template<class T, class RecordT, std::size_t... Is>
+    static T make(const RecordT& record, std::index_sequence<Is...>)
+    {
+      return T{FieldConverter<Ts>::convert(record[Is])...};
+    }
+
+  };
+
+  template<class T>
+  struct is_schema: std::false_type {};
+
+  template<class... Ts>
+  struct is_schema<Schema<Ts...>>: std::true_type {};
+
+}
+
+
+#endif
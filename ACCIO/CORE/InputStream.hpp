@@ -2,48 +2,96 @@
 #define ACCIO_CORE_INPUTSTREAM_HPP_
 
 
+#include "AlignedBuffer.hpp"
 #include "Reader.hpp"
+#include "Statistics.hpp"
+#include <algorithm>
 #include <cassert>
+#include <string>
+#include <string_view>
+#include <type_traits>
 
 
 namespace ACCIO::CORE
 {
 
-  template<class CharT>
+  /// ReaderT に Reader<CharT> の final な派生クラスを指定すると，読み込みは仮想関数呼び出しを介さない．
+  template<class CharT, class ReaderT = Reader<CharT>>
   class InputStream
   {
+    static_assert(std::is_base_of_v<Reader<CharT>, ReaderT>);
+
   public:
 
     using char_type = CharT;
+    using reader_type = ReaderT;
 
   private:
 
     static constexpr std::size_t default_min_buffer_size = 1024;
+    // note: adaptive_ の場合，読み込みがバッファをほぼ満たすことが growth_threshold 回続いたらバッファを倍にする（max_buffer_size まで）．
+    static constexpr std::size_t growth_threshold = 4;
+    static constexpr std::size_t max_buffer_size = 1 << 24;
   
     // note: InputStream がローカル変数ではない状況を加味するとfirst_, last_ は Iterator に持たせたほうがパフォーマンス的にいいかもしれないが，
     // EOF まで読まずにイテレータを破棄した際にイテレータの状態を InputStream に戻すのが面倒．
-    std::unique_ptr<Reader<char_type>> reader_;
+    // note: reader_ が mappable な場合は buffer_ を確保せず，first_, last_ は reader_ の内部の領域を指す．
+    std::unique_ptr<reader_type> reader_;
     std::size_t buffer_size_;
-    std::unique_ptr<char_type[]> buffer_;
+    AlignedArray<char_type> buffer_;
     const char_type* first_;
     const char_type* last_;
+    bool adaptive_;
+    // バッファをほぼ満たした読み込みが続いた回数．
+    std::size_t full_reads_;
+
+    void fill()
+    {
+      ACCIO_STATISTICS_ADD(refills, 1);
+      ACCIO_STATISTICS_TIMER(refill_ns);
+      if(adaptive_ && full_reads_ >= growth_threshold && buffer_size_ < max_buffer_size){
+        // note: fill() はバッファを読み切ってから呼ばれるので，バッファを置き換えてよい．
+        buffer_size_ *= 2;
+        if(buffer_ != nullptr){
+          buffer_ = make_aligned_array<char_type>(buffer_size_);
+        }
+        full_reads_ = 0;
+      }
+      std::size_t n;
+      if(buffer_ != nullptr){
+        n = (*reader_)(buffer_.get(), buffer_size_);
+        first_ = buffer_.get();
+        last_ = first_ + n;
+      }else{
+        auto [first, size] = reader_->map(buffer_size_);
+        n = size;
+        first_ = first;
+        last_ = first_ + n;
+      }
+      if(adaptive_){
+        full_reads_ = n >= buffer_size_ - buffer_size_ / 8 ? full_reads_ + 1 : 0;
+      }
+    }
 
   public:
 
-    explicit InputStream(std::unique_ptr<Reader<char_type>>&& reader):
-      reader_(std::move(reader)), buffer_size_(0), buffer_(), first_(nullptr), last_(nullptr)
+    /// buffer_size はバッファの大きさ（要素数）で，0 の場合は reader の preferred_buffer_size() とする．いずれの場合も reader の min_buffer_size() 以上とする．
+    /// adaptive が true の場合は，読み込みがバッファをほぼ満たし続ける間バッファを大きくする．
+    explicit InputStream(std::unique_ptr<reader_type>&& reader, std::size_t buffer_size = 0, bool adaptive = false):
+      reader_(std::move(reader)), buffer_size_(0), buffer_(), first_(nullptr), last_(nullptr), adaptive_(adaptive), full_reads_(0)
     {
       if(reader_ != nullptr){
-        buffer_size_ = std::max(reader_->min_buffer_size(), default_min_buffer_size);
-        buffer_ = std::make_unique<char_type[]>(buffer_size_);
-        auto n = (*reader_)(buffer_.get(), buffer_size_);
-        first_ = buffer_.get();
-        last_ = first_ + n;      
+        buffer_size_ = std::max({buffer_size != 0 ? buffer_size : reader_->preferred_buffer_size(), reader_->min_buffer_size(), default_min_buffer_size});
+        if(!reader_->mappable()){
+          buffer_ = make_aligned_array<char_type>(buffer_size_);
+        }
+        fill();
       }
     }
 
     InputStream(InputStream&& other) noexcept:
-      reader_(std::move(other.reader_)), buffer_size_(other.buffer_size_), buffer_(std::move(other.buffer_)), first_(other.first_), last_(other.last_)
+      reader_(std::move(other.reader_)), buffer_size_(other.buffer_size_), buffer_(std::move(other.buffer_)), first_(other.first_), last_(other.last_),
+      adaptive_(other.adaptive_), full_reads_(other.full_reads_)
     {
       assert(other.reader_ == nullptr);
       assert(other.buffer_ == nullptr);
@@ -73,9 +121,35 @@ namespace ACCIO::CORE
       assert(!eof());
       ++first_;
       if(first_ == last_){
-        auto n = (*reader_)(buffer_.get(), buffer_size_);
-        first_ = buffer_.get();
-        last_ = first_ + n;      
+        fill();
+      }
+    }
+
+    /// 未読の要素のうち，バッファ上に連続して並んでいるものを返す．EOF の場合は空となる．
+    /// 返された領域は次に next() または consume() を呼び出すまで有効である．
+    std::basic_string_view<char_type> peek_span() const noexcept
+    {
+      return std::basic_string_view<char_type>(first_, static_cast<std::size_t>(last_ - first_));
+    }
+
+    /// peek_span() の先頭 n 要素を読み進める．
+    void consume(std::size_t n)
+    {
+      assert(n <= static_cast<std::size_t>(last_ - first_));
+      first_ += n;
+      if(first_ == last_ && n != 0){
+        fill();
+      }
+    }
+
+    /// EOF まで，バッファ上に連続して並んでいる要素の範囲ごとに f を呼び出して読み進める．
+    template<class F>
+    void for_each_chunk(F&& f)
+    {
+      while(!eof()){
+        auto span = peek_span();
+        f(span);
+        consume(span.size());
       }
     }
 
@@ -160,7 +234,122 @@ namespace ACCIO::CORE
 
   };
 
-  
+  /// メモリ上の連続した領域 [first, last) を入力とするストリーム．領域の所有権は持たない．
+  /// InputStream と同様に CSVParser に渡すことができる．
+  template<class CharT>
+  class SpanInputStream
+  {
+  public:
+
+    using char_type = CharT;
+
+  private:
+
+    const char_type* first_;
+    const char_type* last_;
+
+  public:
+
+    SpanInputStream(const char_type* first, const char_type* last) noexcept:
+      first_(first), last_(last)
+    {}
+
+    SpanInputStream(SpanInputStream&&) = default;
+    SpanInputStream(const SpanInputStream&) = default;
+
+    bool eof() const noexcept
+    {
+      return first_ == last_;
+    }
+
+    std::basic_string_view<char_type> peek_span() const noexcept
+    {
+      return std::basic_string_view<char_type>(first_, static_cast<std::size_t>(last_ - first_));
+    }
+
+    void consume(std::size_t n) noexcept
+    {
+      assert(n <= static_cast<std::size_t>(last_ - first_));
+      first_ += n;
+    }
+
+    template<class F>
+    void for_each_chunk(F&& f)
+    {
+      if(!eof()){
+        f(peek_span());
+        first_ = last_;
+      }
+    }
+
+    const char_type* begin() const noexcept
+    {
+      return first_;
+    }
+
+    const char_type* end() const noexcept
+    {
+      return last_;
+    }
+
+  };
+
+  /// 文字列を所有し，その内容を入力とするストリーム．
+  template<class CharT>
+  class StringInputStream
+  {
+  public:
+
+    using char_type = CharT;
+
+  private:
+
+    // note: ムーブで data() が変わりうるので，読んだ位置は添字で持つ．
+    std::basic_string<char_type> text_;
+    std::size_t position_;
+
+  public:
+
+    explicit StringInputStream(std::basic_string<char_type>&& text) noexcept:
+      text_(std::move(text)), position_(0)
+    {}
+
+    StringInputStream(StringInputStream&&) = default;
+
+    bool eof() const noexcept
+    {
+      return position_ == text_.size();
+    }
+
+    std::basic_string_view<char_type> peek_span() const noexcept
+    {
+      return std::basic_string_view<char_type>(text_.data() + position_, text_.size() - position_);
+    }
+
+    void consume(std::size_t n) noexcept
+    {
+      assert(n <= text_.size() - position_);
+      position_ += n;
+    }
+
+    template<class F>
+    void for_each_chunk(F&& f)
+    {
+      if(!eof()){
+        f(peek_span());
+        position_ = text_.size();
+      }
+    }
+
+  // deleted:
+
+    StringInputStream() = delete;
+    StringInputStream(const StringInputStream&) = delete;
+    StringInputStream& operator=(StringInputStream&&) = delete;
+    StringInputStream& operator=(const StringInputStream&) = delete;
+
+  };
+
 }
 
 
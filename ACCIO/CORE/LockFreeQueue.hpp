@@ -0,0 +1,218 @@
+#ifndef ACCIO_CORE_LOCKFREEQUEUE_HPP_
+#define ACCIO_CORE_LOCKFREEQUEUE_HPP_
+
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include "AlignedBuffer.hpp"
+
+
+namespace ACCIO::CORE
+{
+
+  /// 待つ側の間隔を徐々に延ばす．はじめは CPU を手放さずに待ち，次に yield し，最後は短く眠る．
+  class Backoff
+  {
+  private:
+
+    static constexpr std::size_t spin_limit = 16;
+    static constexpr std::size_t yield_limit = 64;
+
+    std::size_t count_;
+
+  public:
+
+    Backoff() noexcept:
+      count_(0)
+    {}
+
+    void pause() noexcept
+    {
+      if(count_ < spin_limit){
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+      }else if(count_ < yield_limit){
+        std::this_thread::yield();
+      }else{
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+      }
+      ++count_;
+    }
+
+    void reset() noexcept
+    {
+      count_ = 0;
+    }
+
+  };
+
+  // capacity 以上の最小の 2 の冪を返す（2 以上）．
+  inline std::size_t queue_capacity(std::size_t capacity) noexcept
+  {
+    std::size_t result = 2;
+    while(result < capacity) result *= 2;
+    return result;
+  }
+
+  /// 生産側と消費側がそれぞれ 1 つのスレッドである場合の，容量が固定のロックフリーなキュー．
+  /// note: 各側は相手側の位置を手元に写しておき，キューが満杯（空）に見えるときのみ読み直す．
+  template<class T>
+  class SPSCQueue
+  {
+  private:
+
+    std::unique_ptr<T[]> values_;
+    std::size_t mask_;
+    // 消費側が更新する．
+    alignas(cache_line_size) std::atomic<std::size_t> head_;
+    std::size_t tail_cache_;
+    // 生産側が更新する．
+    alignas(cache_line_size) std::atomic<std::size_t> tail_;
+    std::size_t head_cache_;
+
+  public:
+
+    /// capacity 個以上の要素を保持できるキューを作成する（容量は 2 の冪に切り上げる）．
+    explicit SPSCQueue(std::size_t capacity):
+      values_(std::make_unique<T[]>(queue_capacity(capacity))), mask_(queue_capacity(capacity) - 1), head_(0), tail_cache_(0), tail_(0), head_cache_(0)
+    {}
+
+    std::size_t capacity() const noexcept
+    {
+      return mask_ + 1;
+    }
+
+    /// 生産側から value を追加する．キューが満杯の場合は何もせずに false を返す．
+    bool try_push(T&& value)
+    {
+      auto tail = tail_.load(std::memory_order_relaxed);
+      if(tail - head_cache_ > mask_){
+        head_cache_ = head_.load(std::memory_order_acquire);
+        if(tail - head_cache_ > mask_) return false;
+      }
+      values_[tail & mask_] = std::move(value);
+      tail_.store(tail + 1, std::memory_order_release);
+      return true;
+    }
+
+    /// 消費側から先頭の要素を value に取り出す．キューが空の場合は何もせずに false を返す．
+    bool try_pop(T& value)
+    {
+      auto head = head_.load(std::memory_order_relaxed);
+      if(head == tail_cache_){
+        tail_cache_ = tail_.load(std::memory_order_acquire);
+        if(head == tail_cache_) return false;
+      }
+      value = std::move(values_[head & mask_]);
+      head_.store(head + 1, std::memory_order_release);
+      return true;
+    }
+
+  // deleted:
+
+    SPSCQueue() = delete;
+    SPSCQueue(SPSCQueue&&) = delete;
+    SPSCQueue(const SPSCQueue&) = delete;
+    SPSCQueue& operator=(SPSCQueue&&) = delete;
+    SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+  };
+
+  /// 生産側と消費側がそれぞれ複数のスレッドでもよい，容量が固定のロックフリーなキュー．
+  /// note: 各要素に通し番号を持たせ，位置を compare_exchange で確保してから読み書きする（D. Vyukov の bounded MPMC queue）．
+  template<class T>
+  class MPMCQueue
+  {
+  private:
+
+    struct alignas(cache_line_size) Cell
+    {
+      // sequence_ == position であれば position に書き込め，sequence_ == position + 1 であれば position から読み出せる．
+      std::atomic<std::size_t> sequence_;
+      T value_;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    std::size_t mask_;
+    alignas(cache_line_size) std::atomic<std::size_t> head_;
+    alignas(cache_line_size) std::atomic<std::size_t> tail_;
+
+  public:
+
+    /// capacity 個以上の要素を保持できるキューを作成する（容量は 2 の冪に切り上げる）．
+    explicit MPMCQueue(std::size_t capacity):
+      cells_(std::make_unique<Cell[]>(queue_capacity(capacity))), mask_(queue_capacity(capacity) - 1), head_(0), tail_(0)
+    {
+      for(std::size_t i = 0; i <= mask_; ++i){
+        cells_[i].sequence_.store(i, std::memory_order_relaxed);
+      }
+    }
+
+    std::size_t capacity() const noexcept
+    {
+      return mask_ + 1;
+    }
+
+    /// value を追加する．キューが満杯の場合は何もせずに false を返す．
+    bool try_push(T&& value)
+    {
+      auto position = tail_.load(std::memory_order_relaxed);
+      while(true){
+        auto& cell = cells_[position & mask_];
+        auto sequence = cell.sequence_.load(std::memory_order_acquire);
+        auto diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+        if(diff == 0){
+          if(tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)){
+            cell.value_ = std::move(value);
+            cell.sequence_.store(position + 1, std::memory_order_release);
+            return true;
+          }
+        }else if(diff < 0){
+          return false;
+        }else{
+          position = tail_.load(std::memory_order_relaxed);
+        }
+      }
+    }
+
+    /// 先頭の要素を value に取り出す．キューが空の場合は何もせずに false を返す．
+    bool try_pop(T& value)
+    {
+      auto position = head_.load(std::memory_order_relaxed);
+      while(true){
+        auto& cell = cells_[position & mask_];
+        auto sequence = cell.sequence_.load(std::memory_order_acquire);
+        auto diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position + 1);
+        if(diff == 0){
+          if(head_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)){
+            value = std::move(cell.value_);
+            cell.sequence_.store(position + mask_ + 1, std::memory_order_release);
+            return true;
+          }
+        }else if(diff < 0){
+          return false;
+        }else{
+          position = head_.load(std::memory_order_relaxed);
+        }
+      }
+    }
+
+  // deleted:
+
+    MPMCQueue() = delete;
+    MPMCQueue(MPMCQueue&&) = delete;
+    MPMCQueue(const MPMCQueue&) = delete;
+    MPMCQueue& operator=(MPMCQueue&&) = delete;
+    MPMCQueue& operator=(const MPMCQueue&) = delete;
+
+  };
+
+}
+
+
+#endif
@@ -0,0 +1,26 @@
+#include <glob.h>
+#include <stdexcept>
+#include "MultiFileCSVParser.hpp"
+
+
+namespace ACCIO::CORE
+{
+
+  std::vector<std::string> glob_files(const std::string& pattern)
+  {
+    ::glob_t result;
+    auto ret = ::glob(pattern.c_str(), 0, nullptr, &result);
+    if(ret == GLOB_NOMATCH){
+      ::globfree(&result);
+      return {};
+    }
+    if(ret != 0){
+      ::globfree(&result);
+      throw std::runtime_error("Cannot open \"" + pattern + "\".");
+    }
+    std::vector<std::string> file_paths(result.gl_pathv, result.gl_pathv + result.gl_pathc);
+    ::globfree(&result);
+    return file_paths;
+  }
+
+}
@@ -0,0 +1,259 @@
+#ifndef ACCIO_CORE_MULTIFILECSVPARSER_HPP_
+#define ACCIO_CORE_MULTIFILECSVPARSER_HPP_
+
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "BinaryFileReader.hpp"
+#include "CSVParser.hpp"
+#include "Decoder.hpp"
+#include "InputStream.hpp"
+
+
+namespace ACCIO::CORE
+{
+
+  /// pattern（シェルのワイルドカード）に一致するファイルのパスを名前の順に返す．一致するファイルがない場合は空となる．
+  std::vector<std::string> glob_files(const std::string& pattern);
+
+  /// 複数のファイルを複数のスレッドで並行して解析し，レコードのバッチを 1 つの列にまとめて呼び出し元のスレッドに渡す．
+  /// 各ファイルは 1 つのスレッドが先頭から順に解析する．ファイルはあらかじめ各スレッドに割り振り，
+  /// 自分の分を解析し終えたスレッドは他のスレッドの残りを末尾から盗む（work stealing）．
+  /// 解析済みで受け取られていないバッチの数を制限し，それに達した場合は解析するスレッドを待たせる（backpressure）．
+  template<class CharT>
+  class MultiFileCSVParser
+  {
+  public:
+
+    using char_type = CharT;
+    using Record = CSVRecord<char_type>;
+
+    /// for_each_batch に渡されるレコードの組．
+    struct Batch
+    {
+      std::size_t file_id_;    // 何番目のファイルか．
+      std::size_t first_row_;  // 先頭のレコードがファイルの中で何番目のレコードか．
+      std::vector<Record> records_;
+    };
+
+    static constexpr std::size_t batch_size = 4096;
+    // 次に解析する見込みのファイルについて，先読みを促す大きさ．
+    static constexpr std::uint64_t prefetch_size = 4 << 20;
+
+  private:
+
+    // スレッドごとの解析待ちのファイルの列．所有するスレッドは先頭から取り出し，他のスレッドは末尾から盗む．
+    struct WorkQueue
+    {
+      std::mutex mutex_;
+      std::deque<std::size_t> file_ids_;
+    };
+
+    std::vector<std::string> file_paths_;
+    std::string encoding_;
+    CSVOptions<char_type> options_;
+    std::size_t threads_;
+    std::size_t max_batches_;
+
+    // queues[worker] から，空であれば他のスレッドの列から次のファイルを取り出す．
+    static std::optional<std::size_t> take(std::vector<WorkQueue>& queues, std::size_t worker)
+    {
+      {
+        auto& own = queues[worker];
+        std::lock_guard<std::mutex> lock(own.mutex_);
+        if(!own.file_ids_.empty()){
+          auto file_id = own.file_ids_.front();
+          own.file_ids_.pop_front();
+          return file_id;
+        }
+      }
+      for(std::size_t k = 1; k < queues.size(); ++k){
+        auto& victim = queues[(worker + k) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex_);
+        if(!victim.file_ids_.empty()){
+          auto file_id = victim.file_ids_.back();
+          victim.file_ids_.pop_back();
+          return file_id;
+        }
+      }
+      return std::nullopt;
+    }
+
+    // queues[worker] の次のファイルの先読みを促す．
+    // note: ファイルを開いたまま保持すると他のスレッドが盗めなくなるので，開くのは取り出してからとする．
+    void prefetch_next(std::vector<WorkQueue>& queues, std::size_t worker) const
+    {
+      std::optional<std::size_t> file_id;
+      {
+        auto& own = queues[worker];
+        std::lock_guard<std::mutex> lock(own.mutex_);
+        if(!own.file_ids_.empty()) file_id = own.file_ids_.front();
+      }
+      if(file_id) prefetch_file(file_paths_[*file_id], prefetch_size);
+    }
+
+    // file_id 番目のファイルを解析し，batch_size 個ずつ publish に渡す．publish が false を返した場合は中断して false を返す．
+    // 各バッチのレコードは spare() が返す受け取り済みのバッチのレコードに上書きする（空であれば新たに確保する）．
+    template<class F, class G>
+    bool parse_file(std::size_t file_id, F&& publish, G&& spare) const
+    {
+      Batch batch{file_id, 0, spare()};
+      batch.records_.reserve(batch_size);
+      std::size_t size = 0;
+      for(auto&& record: CSVParser<char_type>(InputStream<char_type>(make_decoder<char_type>(make_binary_mmap_reader(file_paths_[file_id]), encoding_)), options_)){
+        if(size < batch.records_.size()){
+          batch.records_[size] = record;
+        }else{
+          batch.records_.push_back(record);
+        }
+        if(++size == batch_size){
+          auto first_row = batch.first_row_ + size;
+          if(!publish(std::move(batch))) return false;
+          batch = Batch{file_id, first_row, spare()};
+          batch.records_.reserve(batch_size);
+          size = 0;
+        }
+      }
+      batch.records_.resize(size);
+      return size == 0 || publish(std::move(batch));
+    }
+
+  public:
+
+    /// file_paths のファイルを threads 個のスレッドで解析する．threads が 0 の場合はハードウェアのスレッド数を用いる．
+    /// max_batches は受け取られていないバッチの数の上限であり，0 の場合はスレッド数の 2 倍とする．
+    MultiFileCSVParser(std::vector<std::string> file_paths, const std::string& encoding, const CSVOptions<char_type>& options = {},
+                       std::size_t threads = 0, std::size_t max_batches = 0):
+      file_paths_(std::move(file_paths)), encoding_(encoding), options_(options),
+      threads_(threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency())), max_batches_(max_batches != 0 ? max_batches : 2 * threads_)
+    {}
+
+    MultiFileCSVParser(MultiFileCSVParser&&) = default;
+
+    const std::vector<std::string>& file_paths() const noexcept
+    {
+      return file_paths_;
+    }
+
+    /// 全てのレコードを最大 batch_size 個ずつまとめて f(batch) に渡す（f は呼び出し元のスレッドで呼ばれる）．
+    /// 同じファイルのバッチはファイルの先頭から順に渡されるが，異なるファイルのバッチの順序は保証されない．
+    /// note: f から戻ったバッチのレコードの領域は後のバッチで再利用するので，f の外でレコードを参照してはならない．
+    template<class F>
+    void for_each_batch(F&& f)
+    {
+      auto n = std::min(threads_, file_paths_.size());
+      if(n == 0) return;
+      std::vector<WorkQueue> queues(n);
+      for(std::size_t i = 0; i < file_paths_.size(); ++i){
+        queues[i % n].file_ids_.push_back(i);
+      }
+      std::mutex mutex;
+      std::condition_variable not_full;
+      std::condition_variable not_empty;
+      std::deque<Batch> batches;
+      // 受け取り済みのバッチのレコード．次に詰めるバッチで領域を再利用する．
+      std::vector<std::vector<Record>> spares;
+      std::size_t running = n;
+      bool stop = false;
+      std::exception_ptr exception;
+      auto publish = [&](Batch&& batch){
+        std::unique_lock<std::mutex> lock(mutex);
+        not_full.wait(lock, [&]{ return stop || batches.size() < max_batches_; });
+        if(stop) return false;
+        batches.push_back(std::move(batch));
+        not_empty.notify_one();
+        return true;
+      };
+      auto spare = [&]{
+        std::vector<Record> records;
+        std::lock_guard<std::mutex> lock(mutex);
+        if(!spares.empty()){
+          records = std::move(spares.back());
+          spares.pop_back();
+        }
+        return records;
+      };
+      auto worker = [&](std::size_t w){
+        try{
+          while(auto file_id = take(queues, w)){
+            prefetch_next(queues, w);
+            if(!parse_file(*file_id, publish, spare)) break;
+          }
+        }catch(...){
+          std::lock_guard<std::mutex> lock(mutex);
+          if(exception == nullptr) exception = std::current_exception();
+          stop = true;
+          not_full.notify_all();
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        --running;
+        not_empty.notify_one();
+      };
+      std::vector<std::thread> threads;
+      for(std::size_t w = 0; w < n; ++w){
+        threads.emplace_back(worker, w);
+      }
+      auto finish = [&]{
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          stop = true;
+          not_full.notify_all();
+        }
+        for(auto&& thread: threads){
+          thread.join();
+        }
+      };
+      try{
+        while(true){
+          Batch batch;
+          {
+            std::unique_lock<std::mutex> lock(mutex);
+            not_empty.wait(lock, [&]{ return exception != nullptr || !batches.empty() || running == 0; });
+            if(exception != nullptr || batches.empty()) break;
+            batch = std::move(batches.front());
+            batches.pop_front();
+            not_full.notify_one();
+          }
+          f(batch);
+          std::lock_guard<std::mutex> lock(mutex);
+          spares.push_back(std::move(batch.records_));
+        }
+      }catch(...){
+        finish();
+        throw;
+      }
+      finish();
+      if(exception != nullptr) std::rethrow_exception(exception);
+    }
+
+    /// 全てのレコードを f(file_id, record) に渡す（f は呼び出し元のスレッドで呼ばれる）．順序は for_each_batch と同じである．
+    template<class F>
+    void for_each(F&& f)
+    {
+      for_each_batch([&](const Batch& batch){
+        for(auto&& record: batch.records_){
+          f(batch.file_id_, record);
+        }
+      });
+    }
+
+  // deleted:
+
+    MultiFileCSVParser() = delete;
+    MultiFileCSVParser(const MultiFileCSVParser&) = delete;
+    MultiFileCSVParser& operator=(MultiFileCSVParser&&) = delete;
+    MultiFileCSVParser& operator=(const MultiFileCSVParser&) = delete;
+
+  };
+
+}
+
+
+#endif
@@ -0,0 +1,165 @@
+#ifndef ACCIO_CORE_OUTPUTSTREAM_HPP_
+#define ACCIO_CORE_OUTPUTSTREAM_HPP_
+
+
+#include "AlignedBuffer.hpp"
+#include "Writer.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
+
+namespace ACCIO::CORE
+{
+
+  /// 書き込む内容をバッファに溜め，バッファが一杯になったときと flush() を呼んだときに WriterT に渡す．
+  /// note: 文字は UTF-8 等のバイト列としてそのまま書き込むので，CharT は 1 バイトの文字型に限る．
+  template<class CharT, class WriterT = BinaryWriter>
+  class OutputStream
+  {
+    static_assert(sizeof(CharT) == 1);
+    static_assert(std::is_base_of_v<BinaryWriter, WriterT>);
+
+  public:
+
+    using char_type = CharT;
+    using writer_type = WriterT;
+
+  private:
+
+    static constexpr std::size_t default_min_buffer_size = 1024;
+
+    std::unique_ptr<writer_type> writer_;
+    std::size_t buffer_size_;
+    // note: writer とバッファを交換できるように，writer と同じ char の配列として持つ．
+    AlignedArray<char> buffer_;
+    // バッファのうち書き込み済みの部分の末尾．
+    char_type* last_;
+    // writer がバッファを引き取れるか．
+    bool swappable_;
+
+    char_type* first() const noexcept
+    {
+      return reinterpret_cast<char_type*>(buffer_.get());
+    }
+
+    void write_buffer()
+    {
+      if(last_ != first()){
+        auto n = static_cast<std::size_t>(last_ - first());
+        if(swappable_){
+          // note: 埋めたバッファを writer に渡し，書き込み終えたバッファを受け取るので，内容はコピーされない．
+          writer_->swap_buffer(buffer_, buffer_size_, n);
+        }else{
+          (*writer_)(buffer_.get(), n);
+        }
+        last_ = first();
+      }
+    }
+
+  public:
+
+    /// buffer_size はバッファの大きさ（要素数）で，0 の場合は writer の preferred_buffer_size() とする．
+    explicit OutputStream(std::unique_ptr<writer_type>&& writer, std::size_t buffer_size = 0):
+      writer_(std::move(writer)), buffer_size_(0), buffer_(), last_(nullptr), swappable_(false)
+    {
+      buffer_size_ = std::max(buffer_size != 0 ? buffer_size : writer_->preferred_buffer_size(), default_min_buffer_size);
+      buffer_ = make_aligned_array<char>(buffer_size_);
+      last_ = first();
+      swappable_ = writer_->swappable();
+    }
+
+    OutputStream(OutputStream&& other) noexcept:
+      writer_(std::move(other.writer_)), buffer_size_(other.buffer_size_), buffer_(std::move(other.buffer_)), last_(other.last_), swappable_(other.swappable_)
+    {
+      other.buffer_size_ = 0;
+      other.last_ = nullptr;
+    }
+
+    /// note: デストラクタでは残りを書き込むが，エラーは無視される．エラーを捕捉する場合は先に flush() を呼ぶこと．
+    ~OutputStream() noexcept
+    {
+      if(writer_ != nullptr){
+        try{
+          write_buffer();
+          writer_->flush();
+        }catch(...){
+        }
+        writer_->close();
+      }
+    }
+
+    std::size_t buffer_size() const noexcept
+    {
+      return buffer_size_;
+    }
+
+    /// 少なくとも n 要素（buffer_size() 以下）を書き込める領域の先頭を返す．書き込んだ要素数を commit() に渡す．
+    char_type* prepare(std::size_t n)
+    {
+      assert(n <= buffer_size_);
+      if(static_cast<std::size_t>(first() + buffer_size_ - last_) < n){
+        write_buffer();
+      }
+      return last_;
+    }
+
+    void commit(std::size_t n) noexcept
+    {
+      assert(n <= static_cast<std::size_t>(first() + buffer_size_ - last_));
+      last_ += n;
+    }
+
+    void put(char_type c)
+    {
+      if(last_ == first() + buffer_size_){
+        write_buffer();
+      }
+      *last_++ = c;
+    }
+
+    void write(const char_type* data, std::size_t n)
+    {
+      auto rest = static_cast<std::size_t>(first() + buffer_size_ - last_);
+      if(n <= rest){
+        std::memcpy(last_, data, n);
+        last_ += n;
+        return;
+      }
+      write_buffer();
+      if(n >= buffer_size_){
+        // note: バッファより大きな内容はバッファを介さずに書き込む．
+        (*writer_)(reinterpret_cast<const char*>(data), n);
+      }else{
+        std::memcpy(last_, data, n);
+        last_ += n;
+      }
+    }
+
+    void write(std::basic_string_view<char_type> s)
+    {
+      write(s.data(), s.size());
+    }
+
+    /// バッファの内容を書き込み，書き込みの完了を待つ．
+    void flush()
+    {
+      write_buffer();
+      writer_->flush();
+    }
+
+  // deleted:
+
+    OutputStream() = delete;
+    OutputStream(const OutputStream&) = delete;
+    OutputStream& operator=(OutputStream&&) = delete;
+    OutputStream& operator=(const OutputStream&) = delete;
+
+  };
+
+}
+
+
+#endif
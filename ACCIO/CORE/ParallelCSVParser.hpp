@@ -0,0 +1,342 @@
+#ifndef ACCIO_CORE_PARALLELCSVPARSER_HPP_
+#define ACCIO_CORE_PARALLELCSVPARSER_HPP_
+
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "BinaryFileReader.hpp"
+#include "CSVIndex.hpp"
+#include "CSVParser.hpp"
+#include "Decoder.hpp"
+#include "InputStream.hpp"
+#include "Reader.hpp"
+#include "SIMD.hpp"
+
+
+namespace ACCIO::CORE
+{
+
+  /// 1 つのファイルを複数のチャンクに分割し，複数のスレッドで並行して解析する．
+  /// チャンクの境界は次のように決める．
+  ///   1. ファイルを等分した各チャンクについて，先頭がダブルクォートの外側である場合と内側である場合のそれぞれを仮定して
+  ///      最初のレコードの区切り（LF）の位置を求め，あわせてダブルクォートの個数の偶奇を数える（並行に行う）．
+  ///   2. 先頭のチャンクから偶奇を累積して各チャンクの先頭の実際の状態を確定させ，対応する仮定の結果を採用する．
+  template<class CharT>
+  class ParallelCSVParser
+  {
+    static_assert(sizeof(CharT) == 1);
+
+  public:
+
+    using char_type = CharT;
+    using Record = CSVRecord<char_type>;
+
+    /// for_each_batch に渡されるレコードの組．
+    struct Batch
+    {
+      std::size_t chunk_id_;   // 何番目のチャンクか．
+      std::size_t first_row_;  // 先頭のレコードがチャンクの中で何番目のレコードか．
+      std::vector<Record> records_;
+    };
+
+    static constexpr std::size_t default_chunk_size = 16 << 20;
+    static constexpr std::size_t batch_size = 4096;
+
+  private:
+
+    static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+    // チャンクを走査した結果．
+    struct ChunkScan
+    {
+      std::size_t first_line_feed_[2];  // 先頭がダブルクォートの外側／内側である場合の，最初の LF の位置．
+      bool parity_;                     // ダブルクォートの個数が奇数であるか．
+    };
+
+    std::unique_ptr<BinaryReader> binary_reader_;
+    std::vector<char> copied_;
+    const char* data_;
+    std::size_t size_;
+    std::string encoding_;
+    char_type delimiter_;
+    std::size_t threads_;
+    std::size_t chunk_size_;
+    // 空でない場合は，split() で求める代わりにこのチャンクの境界を用いる．
+    std::vector<std::size_t> bounds_;
+
+    // [s, s + n) を走査し，先頭が in_quote の状態である場合の最初の LF の位置を返す．parity が非 nullptr ならば最後まで走査して偶奇を求める．
+    static std::size_t scan(const char* s, std::size_t n, bool in_quote, bool* parity, std::uint32_t* positions)
+    {
+      constexpr std::size_t window_size = 1 << 16;
+      std::size_t result = npos;
+      for(std::size_t i = 0; i < n; i += window_size){
+        auto m = std::min(window_size, n - i);
+        // note: 区切り文字に LF を指定すると，ダブルクォートの外側の LF とすべてのダブルクォートの位置が得られる．
+        auto k = index_csv_structurals(s + i, m, '\n', '\"', in_quote, positions);
+        for(std::size_t j = 0; j < k && result == npos; ++j){
+          if(s[i + positions[j]] == '\n') result = i + positions[j];
+        }
+        if(parity == nullptr && result != npos) break;
+      }
+      if(parity != nullptr) *parity = in_quote;
+      return result;
+    }
+
+    // 各スレッドで f(i)（i = 0, ..., n - 1）を実行する．最初に送出された例外を再送出する．
+    template<class F>
+    void run_parallel(std::size_t n, F&& f) const
+    {
+      std::atomic<std::size_t> next(0);
+      std::atomic<bool> failed(false);
+      std::exception_ptr exception;
+      std::mutex mutex;
+      auto worker = [&]{
+        while(!failed.load()){
+          auto i = next.fetch_add(1);
+          if(i >= n) break;
+          try{
+            f(i);
+          }catch(...){
+            std::lock_guard<std::mutex> lock(mutex);
+            if(exception == nullptr) exception = std::current_exception();
+            failed = true;
+          }
+        }
+      };
+      std::vector<std::thread> threads;
+      for(std::size_t t = 1; t < std::min(threads_, n); ++t){
+        threads.emplace_back(worker);
+      }
+      worker();
+      for(auto&& thread: threads){
+        thread.join();
+      }
+      if(exception != nullptr) std::rethrow_exception(exception);
+    }
+
+    // レコードの境界で区切った範囲の境界を返す．i 番目のチャンクは [result[i], result[i + 1]) である．
+    std::vector<std::size_t> split() const
+    {
+      if(!bounds_.empty()) return bounds_;
+      auto k = std::max<std::size_t>(1, (size_ + chunk_size_ - 1) / chunk_size_);
+      std::vector<std::size_t> bounds(k + 1);
+      for(std::size_t i = 0; i <= k; ++i){
+        bounds[i] = static_cast<std::size_t>(static_cast<unsigned __int128>(size_) * i / k);
+      }
+      std::vector<ChunkScan> scans(k);
+      run_parallel(k, [&](std::size_t i){
+        auto positions = std::make_unique<std::uint32_t[]>((1 << 16) + index_padding);
+        auto first = data_ + bounds[i];
+        auto n = bounds[i + 1] - bounds[i];
+        scans[i].first_line_feed_[0] = scan(first, n, false, &scans[i].parity_, positions.get());
+        scans[i].first_line_feed_[1] = scan(first, n, true, nullptr, positions.get());
+      });
+      // 仮定の結果のうち正しいものを採用する．
+      std::vector<std::size_t> result{0};
+      bool in_quote = false;
+      for(std::size_t i = 1; i < k; ++i){
+        in_quote ^= scans[i - 1].parity_;
+        auto line_feed = scans[i].first_line_feed_[in_quote];
+        if(line_feed != npos && bounds[i] + line_feed + 1 < size_){
+          result.push_back(bounds[i] + line_feed + 1);
+        }
+      }
+      result.push_back(size_);
+      return result;
+    }
+
+    // records の末尾にレコードを追加する．spare の同じ位置に要素が残っていれば，その領域を再利用する．
+    // note: レコードはマップした入力を参照したまま写す（入力は ParallelCSVParser が破棄されるまで有効である）．
+    static void append_view(std::vector<Record>& records, std::vector<Record>& spare, const Record& record)
+    {
+      if(records.size() < spare.size()){
+        records.push_back(std::move(spare[records.size()]));
+      }else{
+        records.emplace_back();
+      }
+      records.back().assign_view(record);
+    }
+
+    // [first, last) のチャンクを解析し，各レコードを f に渡す．
+    // note: zero_copy で解析するので，フィールドの多くはマップした入力を直接参照する．
+    template<class F>
+    void parse_chunk(std::size_t first, std::size_t last, F&& f) const
+    {
+      validate_encoding(data_ + first, last - first, encoding_);
+      auto p = reinterpret_cast<const char_type*>(data_);
+      for(auto&& record: CSVParser<char_type>(SpanInputStream<char_type>(p + first, p + last), CSVOptions<char_type>{delimiter_, true})){
+        f(record);
+      }
+    }
+
+  public:
+
+    /// ファイル全体を解析する．ファイルはメモリにマップされ，マップできない場合（パイプ等）は先に全体をメモリに読み込む．
+    /// threads が 0 の場合はハードウェアのスレッド数を用いる．
+    ParallelCSVParser(const std::string& file_path, const std::string& encoding, char_type delimiter,
+                      std::size_t threads = 0, std::size_t chunk_size = default_chunk_size):
+      binary_reader_(make_binary_mmap_reader(file_path)), copied_(), data_(nullptr), size_(0), encoding_(encoding), delimiter_(delimiter),
+      threads_(threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency())), chunk_size_(std::max<std::size_t>(chunk_size, 1)), bounds_()
+    {
+      if(binary_reader_->mappable()){
+        // note: make_binary_mmap_reader の map() はファイルの残り全体を返し，その領域は reader を閉じるまで有効である．
+        auto [first, n] = binary_reader_->map(std::numeric_limits<std::size_t>::max());
+        data_ = first;
+        size_ = n;
+      }else{
+        auto buffer_size = std::max<std::size_t>(binary_reader_->min_buffer_size(), 1 << 20);
+        while(true){
+          auto offset = copied_.size();
+          copied_.resize(offset + buffer_size);
+          auto n = (*binary_reader_)(copied_.data() + offset, buffer_size);
+          copied_.resize(offset + n);
+          if(n == 0) break;
+        }
+        data_ = copied_.data();
+        size_ = copied_.size();
+      }
+    }
+
+    /// index で記録したレコードの位置でファイルを分割する．チャンクの境界を求めるための走査を省ける．
+    ParallelCSVParser(const std::string& file_path, const CSVIndex& index, const std::string& encoding, char_type delimiter,
+                      std::size_t threads = 0, std::size_t chunk_size = default_chunk_size):
+      ParallelCSVParser(file_path, encoding, delimiter, threads, chunk_size)
+    {
+      if(index.file_size() != size_) throw std::runtime_error("index does not match the file.");
+      for(auto [first, last]: index.partition(std::max<std::size_t>(1, (size_ + chunk_size_ - 1) / chunk_size_))){
+        bounds_.push_back(static_cast<std::size_t>(first));
+      }
+      bounds_.push_back(size_);
+    }
+
+    ParallelCSVParser(ParallelCSVParser&&) = default;
+
+    /// 全てのレコードを先頭から順に f(record) に渡す（f は呼び出し元のスレッドで呼ばれる）．
+    /// 同時に保持するチャンクの数は，スレッド数の 2 倍までに制限される．
+    template<class F>
+    void for_each(F&& f)
+    {
+      auto bounds = split();
+      auto n = bounds.size() - 1;
+      auto window = 2 * threads_;
+      std::vector<std::vector<Record>> chunks(n);
+      // 処理し終えたチャンクのレコード．次に解析するチャンクで領域を再利用する．
+      std::vector<std::vector<Record>> spares;
+      std::vector<std::exception_ptr> exceptions(n);
+      std::vector<char> done(n, 0);
+      std::mutex mutex;
+      std::condition_variable condition;
+      std::size_t consumed = 0;
+      bool stop = false;
+      std::atomic<std::size_t> next(0);
+      auto worker = [&]{
+        while(true){
+          auto i = next.fetch_add(1);
+          if(i >= n) return;
+          std::vector<Record> spare;
+          {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [&]{ return stop || i < consumed + window; });
+            if(stop) return;
+            if(!spares.empty()){
+              spare = std::move(spares.back());
+              spares.pop_back();
+            }
+          }
+          std::exception_ptr exception;
+          try{
+            chunks[i].reserve(spare.size());
+            parse_chunk(bounds[i], bounds[i + 1], [&](const Record& record){
+              append_view(chunks[i], spare, record);
+            });
+          }catch(...){
+            exception = std::current_exception();
+          }
+          std::lock_guard<std::mutex> lock(mutex);
+          exceptions[i] = exception;
+          done[i] = 1;
+          condition.notify_all();
+        }
+      };
+      std::vector<std::thread> threads;
+      for(std::size_t t = 0; t < std::min(threads_, n); ++t){
+        threads.emplace_back(worker);
+      }
+      auto finish = [&]{
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          stop = true;
+          condition.notify_all();
+        }
+        for(auto&& thread: threads){
+          thread.join();
+        }
+      };
+      try{
+        for(std::size_t i = 0; i < n; ++i){
+          {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [&]{ return done[i] != 0; });
+            if(exceptions[i] != nullptr) std::rethrow_exception(exceptions[i]);
+          }
+          for(auto&& record: chunks[i]){
+            f(static_cast<const Record&>(record));
+          }
+          std::lock_guard<std::mutex> lock(mutex);
+          spares.push_back(std::move(chunks[i]));
+          consumed = i + 1;
+          condition.notify_all();
+        }
+      }catch(...){
+        finish();
+        throw;
+      }
+      finish();
+    }
+
+    /// 全てのレコードをチャンクごとに最大 batch_size 個ずつまとめて f(batch) に渡す．
+    /// f は複数のスレッドから同時に呼ばれ，バッチの順序は保証されない．
+    /// note: バッチは f から戻ると再利用される．レコードはマップした入力を参照するので，ParallelCSVParser より長く保持する場合はコピーする．
+    template<class F>
+    void for_each_batch(F&& f)
+    {
+      auto bounds = split();
+      run_parallel(bounds.size() - 1, [&](std::size_t i){
+        Batch batch{i, 0, {}};
+        std::vector<Record> spare;
+        batch.records_.reserve(batch_size);
+        parse_chunk(bounds[i], bounds[i + 1], [&](const Record& record){
+          append_view(batch.records_, spare, record);
+          if(batch.records_.size() == batch_size){
+            f(static_cast<const Batch&>(batch));
+            batch.first_row_ += batch.records_.size();
+            // note: 渡したレコードを spare に移し，次のバッチで領域を再利用する．
+            spare.swap(batch.records_);
+            batch.records_.clear();
+          }
+        });
+        if(!batch.records_.empty()){
+          f(static_cast<const Batch&>(batch));
+        }
+      });
+    }
+
+  // deleted:
+
+    ParallelCSVParser() = delete;
+    ParallelCSVParser(const ParallelCSVParser&) = delete;
+    ParallelCSVParser& operator=(ParallelCSVParser&&) = delete;
+    ParallelCSVParser& operator=(const ParallelCSVParser&) = delete;
+
+  };
+
+}
+
+
+#endif
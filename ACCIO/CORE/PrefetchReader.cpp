@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <cassert>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "PrefetchReader.hpp"
+#include "Statistics.hpp"
+
+
+namespace ACCIO::CORE
+{
+
+  class BinaryPrefetchReader final: public BinaryReader
+  {
+  private:
+
+    struct Slot
+    {
+      std::unique_ptr<char[]> buffer_;
+      std::size_t size_;
+    };
+
+    std::unique_ptr<BinaryReader> binary_reader_;
+    std::size_t buffer_size_;
+    std::vector<Slot> slots_;
+    // note: 以下は mutex_ で保護される．filled_ は利用側が処理中のスロットを含む．
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::size_t read_index_;
+    std::size_t write_index_;
+    std::size_t filled_;
+    bool eof_;
+    bool stop_;
+    std::exception_ptr exception_;
+    // 利用側の状態．
+    bool holding_;
+    const char* current_;
+    std::size_t current_size_;
+    std::thread thread_;
+
+    void run() noexcept
+    {
+      try{
+        while(true){
+          std::size_t index;
+          {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this]{ return stop_ || filled_ < slots_.size(); });
+            if(stop_) return;
+            index = write_index_;
+          }
+          // note: slots_[index] は filled_ に数えられるまで利用側から参照されないので，ロックせずに書き込める．
+          auto n = (*binary_reader_)(slots_[index].buffer_.get(), buffer_size_);
+          slots_[index].size_ = n;
+          std::lock_guard<std::mutex> lock(mutex_);
+          if(n == 0){
+            eof_ = true;
+          }else{
+            write_index_ = (write_index_ + 1) % slots_.size();
+            ++filled_;
+          }
+          condition_.notify_all();
+          if(n == 0) return;
+        }
+      }catch(...){
+        std::lock_guard<std::mutex> lock(mutex_);
+        exception_ = std::current_exception();
+        condition_.notify_all();
+      }
+    }
+
+  public:
+
+    BinaryPrefetchReader(std::unique_ptr<BinaryReader>&& binary_reader, std::size_t buffer_size, std::size_t depth):
+      binary_reader_(std::move(binary_reader)), buffer_size_(std::max(buffer_size, binary_reader_->min_buffer_size())), slots_(std::max<std::size_t>(depth, 2)),
+      mutex_(), condition_(), read_index_(0), write_index_(0), filled_(0), eof_(false), stop_(false), exception_(),
+      holding_(false), current_(nullptr), current_size_(0), thread_()
+    {
+      for(auto&& slot: slots_){
+        slot.buffer_ = std::make_unique<char[]>(buffer_size_);
+        slot.size_ = 0;
+      }
+      thread_ = std::thread([this]{ run(); });
+    }
+
+    ~BinaryPrefetchReader() noexcept
+    {
+      close();
+    }
+
+    std::size_t min_buffer_size() const noexcept override
+    {
+      return buffer_size_;
+    }
+
+    std::size_t operator()(char* buffer, std::size_t limit) override
+    {
+      auto [first, n] = map(limit);
+      std::memcpy(buffer, first, n);
+      return n;
+    }
+
+    bool mappable() const noexcept override
+    {
+      return true;
+    }
+
+    std::tuple<const char*, std::size_t> map(std::size_t limit) override
+    {
+      if(current_size_ == 0){
+        std::unique_lock<std::mutex> lock(mutex_);
+        if(holding_){
+          // 処理し終えたスロットを先読みスレッドに返す．
+          read_index_ = (read_index_ + 1) % slots_.size();
+          --filled_;
+          holding_ = false;
+          condition_.notify_all();
+        }
+        {
+          // note: 先読みが間に合わなかった場合のみ待つので，この時間が先読みの不足を表す．
+          ACCIO_STATISTICS_TIMER(read_wait_ns);
+          condition_.wait(lock, [this]{ return filled_ > 0 || eof_ || stop_ || exception_ != nullptr; });
+        }
+        if(stop_ || filled_ == 0){
+          if(!stop_ && exception_ != nullptr) std::rethrow_exception(exception_);
+          return {nullptr, 0};
+        }
+        holding_ = true;
+        current_ = slots_[read_index_].buffer_.get();
+        current_size_ = slots_[read_index_].size_;
+      }
+      auto n = std::min(limit, current_size_);
+      const char* result = current_;
+      current_ += n;
+      current_size_ -= n;
+      return {result, n};
+    }
+
+    void close() noexcept override
+    {
+      // note: 先読みスレッドが read() でブロックしている場合は，それが返るまで待つ．
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+        condition_.notify_all();
+      }
+      if(thread_.joinable()){
+        thread_.join();
+      }
+      if(binary_reader_ != nullptr){
+        binary_reader_->close();
+      }
+      current_ = nullptr;
+      current_size_ = 0;
+    }
+
+  // deleted:
+
+    BinaryPrefetchReader(BinaryPrefetchReader&&) = delete;
+    BinaryPrefetchReader(const BinaryPrefetchReader&) = delete;
+    BinaryPrefetchReader& operator=(BinaryPrefetchReader&&) = delete;
+    BinaryPrefetchReader& operator=(const BinaryPrefetchReader&) = delete;
+
+  };
+
+  std::unique_ptr<BinaryReader> make_binary_prefetch_reader(std::unique_ptr<BinaryReader>&& binary_reader, std::size_t buffer_size, std::size_t depth)
+  {
+    return std::make_unique<BinaryPrefetchReader>(std::move(binary_reader), buffer_size, depth);
+  }
+
+}
@@ -0,0 +1,18 @@
+#ifndef ACCIO_CORE_PREFETCHREADER_HPP_
+#define ACCIO_CORE_PREFETCHREADER_HPP_
+
+
+#include "Reader.hpp"
+
+
+namespace ACCIO::CORE
+{
+
+  /// binary_reader を別スレッドで先読みする BinaryReader を作成する．
+  /// buffer_size バイトのバッファを depth 個（2 以上）用意し，利用側が 1 つを処理している間に残りを埋める．
+  std::unique_ptr<BinaryReader> make_binary_prefetch_reader(std::unique_ptr<BinaryReader>&& binary_reader, std::size_t buffer_size, std::size_t depth);
+
+}
+
+
+#endif
@@ -0,0 +1,79 @@
+#include "Reactor.hpp"
+
+
+#ifdef ACCIO_CORE_HAS_COROUTINE
+
+
+#include <cerrno>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+
+namespace ACCIO::CORE
+{
+
+  Reactor::Reactor():
+    epoll_fd_(::epoll_create1(EPOLL_CLOEXEC)), tasks_(), started_(0)
+  {
+    if(epoll_fd_ < 0) throw std::runtime_error("epoll_create1() failure.");
+  }
+
+  Reactor::~Reactor() noexcept
+  {
+    // note: 終わっていないタスクは，待っているファイル記述子の登録より先に破棄する．
+    tasks_.clear();
+    ::close(epoll_fd_);
+  }
+
+  void Reactor::wait_readable(int fd, std::coroutine_handle<> handle)
+  {
+    // note: EPOLLONESHOT により，1 回通知すると再び登録するまで通知しない．登録済みの場合は MOD で再び有効にする．
+    ::epoll_event event{};
+    event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+    event.data.ptr = handle.address();
+    if(::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event) != 0){
+      if(errno != ENOENT || ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) throw std::runtime_error("epoll_ctl() failure.");
+    }
+  }
+
+  void Reactor::spawn(Task<void>&& task)
+  {
+    tasks_.push_back(std::move(task));
+  }
+
+  void Reactor::run()
+  {
+    constexpr int max_events = 64;
+    ::epoll_event events[max_events];
+    while(true){
+      while(started_ < tasks_.size()){
+        tasks_[started_++].start();
+      }
+      // 終わったタスクを取り除く．
+      for(std::size_t i = 0; i < tasks_.size();){
+        if(tasks_[i].done()){
+          auto task = std::move(tasks_[i]);
+          tasks_.erase(tasks_.begin() + static_cast<std::ptrdiff_t>(i));
+          --started_;
+          task.result();
+        }else{
+          ++i;
+        }
+      }
+      if(tasks_.empty()) return;
+      auto n = ::epoll_wait(epoll_fd_, events, max_events, -1);
+      if(n < 0){
+        if(errno == EINTR) continue;
+        throw std::runtime_error("epoll_wait() failure.");
+      }
+      for(int i = 0; i < n; ++i){
+        std::coroutine_handle<>::from_address(events[i].data.ptr).resume();
+      }
+    }
+  }
+
+}
+
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef ACCIO_CORE_REACTOR_HPP_
+#define ACCIO_CORE_REACTOR_HPP_
+
+
+#include <vector>
+#include "Coroutine.hpp"
+
+
+#ifdef ACCIO_CORE_HAS_COROUTINE
+
+
+namespace ACCIO::CORE
+{
+
+  /// epoll によるスレッドローカルなイベントループ．spawn() したタスクを 1 つのスレッドで並行に実行し，
+  /// ファイル記述子が読めるようになるのを待っているタスクを，読めるようになった時点で再開する．
+  /// note: 複数のスレッドで用いる場合は，スレッドごとに Reactor を作る．
+  class Reactor
+  {
+  private:
+
+    int epoll_fd_;
+    std::vector<Task<void>> tasks_;
+    // tasks_ のうち実行を始めたものの数．
+    std::size_t started_;
+
+    void wait_readable(int fd, std::coroutine_handle<> handle);
+
+  public:
+
+    class ReadableAwaiter
+    {
+    private:
+
+      Reactor& reactor_;
+      int fd_;
+
+    public:
+
+      ReadableAwaiter(Reactor& reactor, int fd) noexcept:
+        reactor_(reactor), fd_(fd)
+      {}
+
+      bool await_ready() const noexcept
+      {
+        return false;
+      }
+
+      void await_suspend(std::coroutine_handle<> handle) const
+      {
+        reactor_.wait_readable(fd_, handle);
+      }
+
+      void await_resume() const noexcept
+      {}
+
+    };
+
+    Reactor();
+
+    ~Reactor() noexcept;
+
+    /// co_await すると，fd が読めるようになる（または EOF やエラーに達する）まで待つ．
+    ReadableAwaiter readable(int fd) noexcept
+    {
+      return ReadableAwaiter(*this, fd);
+    }
+
+    /// task を登録する．task は run() の中で実行を始める．
+    void spawn(Task<void>&& task);
+
+    /// spawn() したタスクがすべて終わるまでイベントを処理する．
+    /// タスクから例外が送出された場合は，そのタスクを取り除いて再送出する（run() を再び呼べば残りのタスクを続ける）．
+    void run();
+
+  // deleted:
+
+    Reactor(Reactor&&) = delete;
+    Reactor(const Reactor&) = delete;
+    Reactor& operator=(Reactor&&) = delete;
+    Reactor& operator=(const Reactor&) = delete;
+
+  };
+
+}
+
+
+#endif
+
+
+#endif
@@ -4,6 +4,7 @@
 
 #include <cstdint>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <tuple>
 #include "char8_t.hpp"
@@ -22,9 +23,29 @@ namespace ACCIO::CORE
     virtual ~Reader() = default;
 
     virtual std::size_t min_buffer_size() const noexcept = 0;
+
+    /// 1 回の読み込みで要求すると効率のよい要素数を返す．InputStream はこれをバッファの大きさの既定値とする．
+    virtual std::size_t preferred_buffer_size() const noexcept
+    {
+      return min_buffer_size();
+    }
   
     virtual std::size_t operator()(char_type* buffer, std::size_t limit) = 0;
 
+    /// 読み込み元のメモリ領域をコピーせずに参照させられる場合は true を返す．
+    virtual bool mappable() const noexcept
+    {
+      return false;
+    }
+
+    /// 最大 limit 要素をコピーせずに読み進め，その領域の先頭と要素数を返す（mappable() が true の場合のみ呼び出せる）．
+    /// 返された領域は次に map() または operator() が呼び出されるまで有効である．要素数 0 は EOF を表す．
+    virtual std::tuple<const char_type*, std::size_t> map(std::size_t limit)
+    {
+      static_cast<void>(limit);
+      throw std::logic_error("map() is not supported.");
+    }
+
     virtual void close() noexcept = 0;
   
   };
@@ -0,0 +1,684 @@
+#ifndef ACCIO_CORE_RECORDBATCH_HPP_
+#define ACCIO_CORE_RECORDBATCH_HPP_
+
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#include "Arena.hpp"
+#include "CSVParser.hpp"
+#include "FieldConverter.hpp"
+
+
+// note: 各列のバッファは Apache Arrow の列指向フォーマットと同じ配置である．
+// validity は LSB が先頭の要素に対応するビットマップで，ビットが 1 の要素が有効（非 null）を表す．
+// 文字列の列は Arrow の utf8 型と同様に，長さ (要素数 + 1) の int32 の offsets と連続した data を持つ．
+// bool の列は値も同じ形式のビットマップで持ち（boolean 型），Date の列は 1970-01-01 からの日数を int32 で持つ（date32 型）．
+
+
+namespace ACCIO::CORE
+{
+
+  class ValidityBitmap
+  {
+  private:
+
+    std::vector<std::uint8_t> bits_;
+    std::size_t size_;
+    std::size_t null_count_;
+
+  public:
+
+    ValidityBitmap():
+      bits_(), size_(0), null_count_(0)
+    {}
+
+    void push_back(bool is_valid)
+    {
+      if(size_ % 8 == 0){
+        bits_.push_back(0);
+      }
+      if(is_valid){
+        bits_.back() |= static_cast<std::uint8_t>(1u << (size_ % 8));
+      }else{
+        ++null_count_;
+      }
+      ++size_;
+    }
+
+    bool operator[](std::size_t i) const noexcept
+    {
+      assert(i < size_);
+      return (bits_[i / 8] >> (i % 8)) & 1;
+    }
+
+    std::size_t size() const noexcept
+    {
+      return size_;
+    }
+
+    std::size_t null_count() const noexcept
+    {
+      return null_count_;
+    }
+
+    const std::uint8_t* data() const noexcept
+    {
+      return bits_.data();
+    }
+
+    void reserve(std::size_t n)
+    {
+      bits_.reserve((n + 7) / 8);
+    }
+
+  };
+
+  /// 可変長の文字列の列．
+  template<class CharT>
+  class StringColumn
+  {
+  public:
+
+    using char_type = CharT;
+    using string_view = std::basic_string_view<char_type>;
+
+  private:
+
+    std::vector<std::int32_t> offsets_;
+    std::vector<char_type> data_;
+    ValidityBitmap validity_;
+
+  public:
+
+    StringColumn():
+      offsets_(1, 0), data_(), validity_()
+    {}
+
+    void append(string_view value)
+    {
+      if(data_.size() + value.size() > static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max())){
+        throw std::runtime_error("column too large.");
+      }
+      data_.insert(data_.end(), value.begin(), value.end());
+      offsets_.push_back(static_cast<std::int32_t>(data_.size()));
+      validity_.push_back(true);
+    }
+
+    void append_null()
+    {
+      offsets_.push_back(offsets_.back());
+      validity_.push_back(false);
+    }
+
+    std::size_t size() const noexcept
+    {
+      return validity_.size();
+    }
+
+    /// i 番目の要素を返す．null の場合は空となる．
+    string_view operator[](std::size_t i) const noexcept
+    {
+      assert(i < size());
+      return string_view(data_.data() + offsets_[i], static_cast<std::size_t>(offsets_[i + 1] - offsets_[i]));
+    }
+
+    bool is_valid(std::size_t i) const noexcept
+    {
+      return validity_[i];
+    }
+
+    std::size_t null_count() const noexcept
+    {
+      return validity_.null_count();
+    }
+
+    const std::int32_t* offsets() const noexcept
+    {
+      return offsets_.data();
+    }
+
+    const char_type* data() const noexcept
+    {
+      return data_.data();
+    }
+
+    const std::uint8_t* validity() const noexcept
+    {
+      return validity_.data();
+    }
+
+    void reserve(std::size_t rows)
+    {
+      offsets_.reserve(rows + 1);
+      validity_.reserve(rows);
+    }
+
+  };
+
+  /// 固定長の値の列．
+  template<class T>
+  class PrimitiveColumn
+  {
+  public:
+
+    using value_type = T;
+
+  private:
+
+    std::vector<value_type> values_;
+    ValidityBitmap validity_;
+
+  public:
+
+    PrimitiveColumn():
+      values_(), validity_()
+    {}
+
+    void append(const value_type& value)
+    {
+      values_.push_back(value);
+      validity_.push_back(true);
+    }
+
+    void append_null()
+    {
+      values_.push_back(value_type());
+      validity_.push_back(false);
+    }
+
+    std::size_t size() const noexcept
+    {
+      return values_.size();
+    }
+
+    /// i 番目の要素を返す．null の場合は value_type() となる．
+    const value_type& operator[](std::size_t i) const noexcept
+    {
+      assert(i < size());
+      return values_[i];
+    }
+
+    bool is_valid(std::size_t i) const noexcept
+    {
+      return validity_[i];
+    }
+
+    std::size_t null_count() const noexcept
+    {
+      return validity_.null_count();
+    }
+
+    const value_type* data() const noexcept
+    {
+      return values_.data();
+    }
+
+    const std::uint8_t* validity() const noexcept
+    {
+      return validity_.data();
+    }
+
+    void reserve(std::size_t rows)
+    {
+      values_.reserve(rows);
+      validity_.reserve(rows);
+    }
+
+  };
+
+  /// bool の列．値も validity と同じく LSB が先頭の要素に対応するビットマップに格納する（Arrow の boolean 型）．
+  class BooleanColumn
+  {
+  public:
+
+    using value_type = bool;
+
+  private:
+
+    // note: 配置が同じなので ValidityBitmap で表す（null_count() は false の数となる）．
+    ValidityBitmap values_;
+    ValidityBitmap validity_;
+
+  public:
+
+    BooleanColumn():
+      values_(), validity_()
+    {}
+
+    void append(value_type value)
+    {
+      values_.push_back(value);
+      validity_.push_back(true);
+    }
+
+    void append_null()
+    {
+      values_.push_back(false);
+      validity_.push_back(false);
+    }
+
+    std::size_t size() const noexcept
+    {
+      return values_.size();
+    }
+
+    /// i 番目の要素を返す．null の場合は false となる．
+    value_type operator[](std::size_t i) const noexcept
+    {
+      assert(i < size());
+      return values_[i];
+    }
+
+    bool is_valid(std::size_t i) const noexcept
+    {
+      return validity_[i];
+    }
+
+    std::size_t null_count() const noexcept
+    {
+      return validity_.null_count();
+    }
+
+    const std::uint8_t* data() const noexcept
+    {
+      return values_.data();
+    }
+
+    const std::uint8_t* validity() const noexcept
+    {
+      return validity_.data();
+    }
+
+    void reserve(std::size_t rows)
+    {
+      values_.reserve(rows);
+      validity_.reserve(rows);
+    }
+
+  };
+
+  namespace DETAIL
+  {
+
+    // 1970-01-01 からの日数を返す（先発グレゴリオ暦）．
+    inline std::int32_t days_from_date(const Date& date) noexcept
+    {
+      std::int64_t y = date.year - (date.month <= 2 ? 1 : 0);
+      std::int64_t era = (y >= 0 ? y : y - 399) / 400;
+      std::int64_t yoe = y - era * 400;
+      std::int64_t m = date.month;
+      std::int64_t doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + date.day - 1;
+      std::int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+      return static_cast<std::int32_t>(era * 146097 + doe - 719468);
+    }
+
+    inline Date date_from_days(std::int32_t days) noexcept
+    {
+      std::int64_t z = static_cast<std::int64_t>(days) + 719468;
+      std::int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+      std::int64_t doe = z - era * 146097;
+      std::int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+      std::int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+      std::int64_t mp = (5 * doy + 2) / 153;
+      auto day = static_cast<unsigned>(doy - (153 * mp + 2) / 5 + 1);
+      auto month = static_cast<unsigned>(mp < 10 ? mp + 3 : mp - 9);
+      return Date{static_cast<int>(yoe + era * 400 + (month <= 2 ? 1 : 0)), month, day};
+    }
+
+  }
+
+  /// Date の列．値は 1970-01-01 からの日数を int32 で格納する（Arrow の date32 型）．
+  class Date32Column
+  {
+  public:
+
+    using value_type = Date;
+
+  private:
+
+    PrimitiveColumn<std::int32_t> days_;
+
+  public:
+
+    Date32Column():
+      days_()
+    {}
+
+    void append(const value_type& value)
+    {
+      days_.append(DETAIL::days_from_date(value));
+    }
+
+    void append_null()
+    {
+      days_.append_null();
+    }
+
+    std::size_t size() const noexcept
+    {
+      return days_.size();
+    }
+
+    /// i 番目の要素を返す．null の場合は 1970-01-01 となる．
+    value_type operator[](std::size_t i) const noexcept
+    {
+      return DETAIL::date_from_days(days_[i]);
+    }
+
+    bool is_valid(std::size_t i) const noexcept
+    {
+      return days_.is_valid(i);
+    }
+
+    std::size_t null_count() const noexcept
+    {
+      return days_.null_count();
+    }
+
+    const std::int32_t* data() const noexcept
+    {
+      return days_.data();
+    }
+
+    const std::uint8_t* validity() const noexcept
+    {
+      return days_.validity();
+    }
+
+    void reserve(std::size_t rows)
+    {
+      days_.reserve(rows);
+    }
+
+  };
+
+  /// Schema の型 T の値を格納する列の型．文字列は StringColumn に，bool は BooleanColumn に，Date は Date32Column に，それ以外は PrimitiveColumn に格納する．
+  template<class CharT, class T>
+  struct ColumnOf
+  {
+    using type = PrimitiveColumn<T>;
+  };
+
+  template<class CharT>
+  struct ColumnOf<CharT, bool>
+  {
+    using type = BooleanColumn;
+  };
+
+  template<class CharT>
+  struct ColumnOf<CharT, Date>
+  {
+    using type = Date32Column;
+  };
+
+  template<class CharT>
+  struct ColumnOf<CharT, std::basic_string_view<CharT>>
+  {
+    using type = StringColumn<CharT>;
+  };
+
+  template<class CharT>
+  struct ColumnOf<CharT, std::basic_string<CharT>>
+  {
+    using type = StringColumn<CharT>;
+  };
+
+  // note: 列は null を表せるので，std::optional は外す．
+  template<class CharT, class T>
+  struct ColumnOf<CharT, std::optional<T>>: ColumnOf<CharT, T> {};
+
+  /// すべての列を文字列として格納するバッチ．列数はバッチ内で最も要素の多いレコードに合わせ，足りない要素は null とする．
+  template<class CharT>
+  class RecordBatch
+  {
+  public:
+
+    using char_type = CharT;
+    using Column = StringColumn<char_type>;
+
+  private:
+
+    std::vector<Column> columns_;
+    std::size_t num_rows_;
+
+  public:
+
+    RecordBatch():
+      columns_(), num_rows_(0)
+    {}
+
+    template<class RecordT>
+    void append(const RecordT& record)
+    {
+      while(columns_.size() < record.size()){
+        columns_.emplace_back();
+        for(std::size_t i = 0; i < num_rows_; ++i){
+          columns_.back().append_null();
+        }
+      }
+      for(std::size_t i = 0; i < columns_.size(); ++i){
+        if(i < record.size()){
+          columns_[i].append(record[i]);
+        }else{
+          columns_[i].append_null();
+        }
+      }
+      ++num_rows_;
+    }
+
+    std::size_t num_rows() const noexcept
+    {
+      return num_rows_;
+    }
+
+    std::size_t num_columns() const noexcept
+    {
+      return columns_.size();
+    }
+
+    const Column& column(std::size_t i) const noexcept
+    {
+      assert(i < columns_.size());
+      return columns_[i];
+    }
+
+  };
+
+  /// SchemaT に従って変換した値を列ごとに格納するバッチ．
+  /// 空のフィールドと，レコードに存在しない列は null とする（文字列の列では空のフィールドは空文字列とする）．
+  template<class CharT, class SchemaT>
+  class TypedRecordBatch;
+
+  template<class CharT, class... Ts>
+  class TypedRecordBatch<CharT, Schema<Ts...>>
+  {
+  public:
+
+    using char_type = CharT;
+
+  private:
+
+    std::tuple<typename ColumnOf<char_type, Ts>::type...> columns_;
+    std::size_t num_rows_;
+
+    template<class T, class RecordT>
+    static void append_field(typename ColumnOf<char_type, T>::type& column, const RecordT& record, std::size_t i)
+    {
+      if constexpr(std::is_same_v<typename ColumnOf<char_type, T>::type, StringColumn<char_type>>){
+        if(i < record.size()){
+          column.append(record[i]);
+        }else{
+          column.append_null();
+        }
+      }else{
+        if(i < record.size() && !record[i].empty()){
+          column.append(FieldConverter<typename ColumnOf<char_type, T>::type::value_type>::convert(record[i]));
+        }else{
+          column.append_null();
+        }
+      }
+    }
+
+    template<class RecordT, std::size_t... Is>
+    void append(const RecordT& record, std::index_sequence<Is...>)
+    {
+      (append_field<Ts>(std::get<Is>(columns_), record, Is), ...);
+    }
+
+  public:
+
+    TypedRecordBatch():
+      columns_(), num_rows_(0)
+    {}
+
+    template<class RecordT>
+    void append(const RecordT& record)
+    {
+      append(record, std::index_sequence_for<Ts...>());
+      ++num_rows_;
+    }
+
+    std::size_t num_rows() const noexcept
+    {
+      return num_rows_;
+    }
+
+    static constexpr std::size_t num_columns() noexcept
+    {
+      return sizeof...(Ts);
+    }
+
+    template<std::size_t I>
+    const auto& column() const noexcept
+    {
+      return std::get<I>(columns_);
+    }
+
+  };
+
+  /// レコードをそのまま保持するバッチ．レコードの内容はすべて 1 つの Arena に置き，clear() でまとめて解放する．
+  /// note: Arena は前回のバッチで使った大きさを覚えているので，同程度のバッチを繰り返し読む場合は 1 つの連続した領域に収まる．
+  template<class CharT>
+  class ArenaRecordBatch
+  {
+  public:
+
+    using char_type = CharT;
+    using Record = CSVRecord<char_type, ArenaAllocator<char_type>>;
+
+  private:
+
+    Arena arena_;
+    std::vector<Record> records_;
+
+  public:
+
+    ArenaRecordBatch():
+      arena_(), records_()
+    {}
+
+    explicit ArenaRecordBatch(std::size_t block_size):
+      arena_(block_size), records_()
+    {}
+
+    template<class AllocatorT>
+    void append(const CSVRecord<char_type, AllocatorT>& record)
+    {
+      records_.emplace_back(record, ArenaAllocator<char_type>(arena_));
+    }
+
+    /// すべてのレコードを破棄し，Arena を再利用できるようにする．
+    void clear()
+    {
+      records_.clear();
+      arena_.reset();
+    }
+
+    std::size_t size() const noexcept
+    {
+      return records_.size();
+    }
+
+    const Record& operator[](std::size_t i) const noexcept
+    {
+      assert(i < records_.size());
+      return records_[i];
+    }
+
+    auto begin() const noexcept
+    {
+      return records_.begin();
+    }
+
+    auto end() const noexcept
+    {
+      return records_.end();
+    }
+
+    /// Arena から確保した大きさの合計を返す．
+    std::size_t arena_used() const noexcept
+    {
+      return arena_.used();
+    }
+
+  // deleted:
+
+    ArenaRecordBatch(ArenaRecordBatch&&) = delete;
+    ArenaRecordBatch(const ArenaRecordBatch&) = delete;
+    ArenaRecordBatch& operator=(ArenaRecordBatch&&) = delete;
+    ArenaRecordBatch& operator=(const ArenaRecordBatch&) = delete;
+
+  };
+
+  /// batch を空にしてから，parser から最大 max_rows 個のレコードを読んで格納する．格納したレコード数を返す．
+  template<class ParserT>
+  std::size_t read_batch(ParserT& parser, ArenaRecordBatch<typename ParserT::Record::char_type>& batch, std::size_t max_rows)
+  {
+    batch.clear();
+    auto first = parser.begin();
+    auto last = parser.end();
+    for(std::size_t i = 0; i < max_rows && first != last; ++i, ++first){
+      batch.append(*first);
+    }
+    return batch.size();
+  }
+
+  /// parser から最大 max_rows 個のレコードを読み，列ごとのバッファに格納する．読み切った場合は num_rows() が max_rows 未満となる．
+  template<class ParserT>
+  RecordBatch<typename ParserT::Record::char_type> read_batch(ParserT& parser, std::size_t max_rows)
+  {
+    RecordBatch<typename ParserT::Record::char_type> batch;
+    auto first = parser.begin();
+    auto last = parser.end();
+    // note: ++first で次のレコードが parser に読み込まれるので，次の呼び出しはそのレコードから始まる．
+    for(std::size_t i = 0; i < max_rows && first != last; ++i, ++first){
+      batch.append(*first);
+    }
+    return batch;
+  }
+
+  /// parser から最大 max_rows 個のレコードを読み，SchemaT に従って変換して列ごとのバッファに格納する．
+  template<class SchemaT, class ParserT, std::enable_if_t<is_schema<SchemaT>::value>* = nullptr>
+  TypedRecordBatch<typename ParserT::Record::char_type, SchemaT> read_batch(ParserT& parser, std::size_t max_rows)
+  {
+    TypedRecordBatch<typename ParserT::Record::char_type, SchemaT> batch;
+    auto first = parser.begin();
+    auto last = parser.end();
+    for(std::size_t i = 0; i < max_rows && first != last; ++i, ++first){
+      batch.append(*first);
+    }
+    return batch;
+  }
+
+}
+
+
+#endif
@@ -0,0 +1,630 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include "SIMD.hpp"
+#if defined(__GNUC__) && defined(__x86_64__)
+#define ACCIO_CORE_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+
+namespace ACCIO::CORE
+{
+
+  // i の直前の文字が完結していなければ，その文字の先頭の位置を返す．そうでなければ i を返す．
+  // note: [0, i) は妥当な UTF-8 文字列の途中までであることを前提とする．
+  static std::size_t back_to_char_boundary(const char* s, std::size_t i) noexcept
+  {
+    for(std::size_t k = 1; k <= 3 && k <= i; ++k){
+      auto c = static_cast<std::uint8_t>(s[i - k]);
+      if((c & 0xC0) != 0x80){
+        std::size_t length = c < 0x80 ? 1 : c < 0xE0 ? 2 : c < 0xF0 ? 3 : 4;
+        return length > k ? i - k : i;
+      }
+    }
+    return i;
+  }
+
+  static std::size_t skip_valid_utf8_scalar(const char*, std::size_t) noexcept
+  {
+    return 0;
+  }
+
+  // note: SIMD 命令が使えない場合でも，8 バイトずつまとめて判定する．
+  static bool is_ascii_scalar(const char* s, std::size_t n) noexcept
+  {
+    std::uint64_t bits = 0;
+    std::size_t i = 0;
+    for(; i + 8 <= n; i += 8){
+      std::uint64_t word;
+      std::memcpy(&word, s + i, 8);
+      bits |= word;
+    }
+    for(; i < n; ++i){
+      bits |= static_cast<std::uint8_t>(s[i]);
+    }
+    return (bits & 0x8080808080808080ull) == 0;
+  }
+
+  // ビット i が bits のビット 0..i の排他的論理和となる値を返す（ダブルクォートの内側を表すマスクの計算に用いる）．
+  static inline std::uint64_t prefix_xor(std::uint64_t bits) noexcept
+  {
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+  }
+
+  // bits の立っているビットの位置に base を加えて positions に書き込む．
+  // note: 分岐予測の失敗を減らすため，8 個ずつ個数によらずに書き込み，最後に実際の個数だけ進める（Langdale & Lemire, "Parsing Gigabytes of JSON per Second"）．
+  // そのため positions の末尾から index_padding - 1 要素先まで書き込むことがある．
+  static inline std::uint32_t* flatten_bits(std::uint32_t* positions, std::uint32_t base, std::uint64_t bits) noexcept
+  {
+    static_assert(index_padding >= 8);
+    if(bits == 0) return positions;
+    auto count = static_cast<std::size_t>(__builtin_popcountll(bits));
+    auto out = positions;
+    do{
+      for(int i = 0; i < 8; ++i){
+        // note: bits が 0 になった後の値は捨てられる．
+        out[i] = base + static_cast<std::uint32_t>(__builtin_ctzll(bits | (1ull << 63)));
+        bits &= bits - 1;
+      }
+      out += 8;
+    }while(bits != 0);
+    return positions + count;
+  }
+
+  // 64 バイトのブロックの構造文字を positions に書き込む．quote, delimiter, line_feed はそれぞれの文字の位置を表すビット列．
+  static inline std::uint32_t* flatten_block(std::uint32_t* positions, std::uint32_t base, std::uint64_t quote, std::uint64_t delimiter, std::uint64_t line_feed,
+                                             std::uint64_t inside, std::uint64_t& carry) noexcept
+  {
+    inside ^= carry;
+    carry = static_cast<std::uint64_t>(static_cast<std::int64_t>(inside) >> 63);
+    return flatten_bits(positions, base, ((delimiter | line_feed) & ~inside) | quote);
+  }
+
+  [[maybe_unused]] static std::size_t index_csv_structurals_scalar(const char* s, std::size_t n, char delimiter, char quote, bool& in_quote, std::uint32_t* positions) noexcept
+  {
+    std::uint64_t carry = in_quote ? ~0ull : 0;
+    auto out = positions;
+    for(std::size_t i = 0; i < n; i += 64){
+      std::uint64_t q = 0, d = 0, l = 0;
+      auto m = std::min<std::size_t>(64, n - i);
+      for(std::size_t j = 0; j < m; ++j){
+        q |= static_cast<std::uint64_t>(s[i + j] == quote) << j;
+        d |= static_cast<std::uint64_t>(s[i + j] == delimiter) << j;
+        l |= static_cast<std::uint64_t>(s[i + j] == '\n') << j;
+      }
+      out = flatten_block(out, static_cast<std::uint32_t>(i), q, d, l, prefix_xor(q), carry);
+    }
+    in_quote = carry != 0;
+    return static_cast<std::size_t>(out - positions);
+  }
+
+  [[maybe_unused]] static std::size_t index_csv_separators_scalar(const char* s, std::size_t n, char delimiter, std::uint32_t* positions) noexcept
+  {
+    auto out = positions;
+    for(std::size_t i = 0; i < n; ++i){
+      if(s[i] == delimiter || s[i] == '\n') *out++ = static_cast<std::uint32_t>(i);
+    }
+    return static_cast<std::size_t>(out - positions);
+  }
+
+  static bool needs_csv_quote_scalar(const char* s, std::size_t n, char delimiter) noexcept
+  {
+    for(std::size_t i = 0; i < n; ++i){
+      if(s[i] == '\"' || s[i] == delimiter || s[i] == '\n' || s[i] == '\r') return true;
+    }
+    return false;
+  }
+
+#ifdef ACCIO_CORE_SIMD_X86
+
+  // UTF-8 の検証は Keiser & Lemire, "Validating UTF-8 In Less Than One Instruction Per Byte" (2021) の方法による．
+  // 連続する 2 バイトの上位・下位 4 ビットを表引きし，その論理積でエラーの種類を判定する．
+  namespace utf8_lookup
+  {
+    constexpr std::uint8_t TOO_SHORT = 1 << 0;       // 11______ 0_______, 11______ 11______
+    constexpr std::uint8_t TOO_LONG = 1 << 1;        // 0_______ 10______
+    constexpr std::uint8_t OVERLONG_3 = 1 << 2;      // 11100000 100_____
+    constexpr std::uint8_t TOO_LARGE = 1 << 3;       // 11110100 1001____ など
+    constexpr std::uint8_t SURROGATE = 1 << 4;       // 11101101 101_____
+    constexpr std::uint8_t OVERLONG_2 = 1 << 5;      // 1100000_ 10______
+    constexpr std::uint8_t TOO_LARGE_1000 = 1 << 6;  // 11110101 1000____ など
+    constexpr std::uint8_t OVERLONG_4 = 1 << 6;      // 11110000 1000____
+    constexpr std::uint8_t TWO_CONTS = 1 << 7;       // 10______ 10______
+    constexpr std::uint8_t CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+    constexpr std::uint8_t byte_1_high[16] = {
+      TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+      TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+      TOO_SHORT | OVERLONG_2,
+      TOO_SHORT,
+      TOO_SHORT | OVERLONG_3 | SURROGATE,
+      TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4
+    };
+
+    constexpr std::uint8_t byte_1_low[16] = {
+      CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+      CARRY | OVERLONG_2,
+      CARRY,
+      CARRY,
+      CARRY | TOO_LARGE,
+      CARRY | TOO_LARGE | TOO_LARGE_1000,
+      CARRY | TOO_LARGE | TOO_LARGE_1000,
+      CARRY | TOO_LARGE | TOO_LARGE_1000,
+      CARRY | TOO_LARGE | TOO_LARGE_1000,
+      CARRY | TOO_LARGE | TOO_LARGE_1000,
+      CARRY | TOO_LARGE | TOO_LARGE_1000,
+      CARRY | TOO_LARGE | TOO_LARGE_1000,
+      CARRY | TOO_LARGE | TOO_LARGE_1000,
+      CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+      CARRY | TOO_LARGE | TOO_LARGE_1000,
+      CARRY | TOO_LARGE | TOO_LARGE_1000
+    };
+
+    constexpr std::uint8_t byte_2_high[16] = {
+      TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+      TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+      TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+      TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+      TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+      TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT
+    };
+
+    // 末尾の 3 バイトに，後続のバイトを必要とする先頭バイトが含まれているかの判定に用いる．
+    constexpr std::uint8_t incomplete_max[64] = {
+      255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+      255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+      255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+      255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1
+    };
+  }
+
+  __attribute__((target("ssse3")))
+  static std::size_t skip_valid_utf8_ssse3(const char* s, std::size_t n) noexcept
+  {
+    using namespace utf8_lookup;
+    const auto table_1_high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(byte_1_high));
+    const auto table_1_low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(byte_1_low));
+    const auto table_2_high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(byte_2_high));
+    const auto max_value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(incomplete_max + 48));
+    const auto low_nibble = _mm_set1_epi8(0x0F);
+    auto prev_input = _mm_setzero_si128();
+    auto prev_incomplete = _mm_setzero_si128();
+    std::size_t i = 0;
+    for(; i + 16 <= n; i += 16){
+      auto input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+      __m128i error;
+      if(_mm_movemask_epi8(input) == 0){
+        // ASCII のみ．直前のブロックが文字の途中で終わっていればエラーとなる．
+        error = prev_incomplete;
+        prev_incomplete = _mm_setzero_si128();
+      }else{
+        auto prev1 = _mm_alignr_epi8(input, prev_input, 15);
+        auto prev2 = _mm_alignr_epi8(input, prev_input, 14);
+        auto prev3 = _mm_alignr_epi8(input, prev_input, 13);
+        auto special = _mm_and_si128(
+          _mm_and_si128(_mm_shuffle_epi8(table_1_high, _mm_and_si128(_mm_srli_epi16(prev1, 4), low_nibble)),
+                        _mm_shuffle_epi8(table_1_low, _mm_and_si128(prev1, low_nibble))),
+          _mm_shuffle_epi8(table_2_high, _mm_and_si128(_mm_srli_epi16(input, 4), low_nibble)));
+        auto must23 = _mm_or_si128(_mm_subs_epu8(prev2, _mm_set1_epi8(static_cast<char>(0xE0 - 0x80))),
+                                   _mm_subs_epu8(prev3, _mm_set1_epi8(static_cast<char>(0xF0 - 0x80))));
+        error = _mm_xor_si128(_mm_and_si128(must23, _mm_set1_epi8(static_cast<char>(0x80))), special);
+        prev_incomplete = _mm_subs_epu8(input, max_value);
+      }
+      if(_mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) != 0xFFFF) break;
+      prev_input = input;
+    }
+    return back_to_char_boundary(s, i);
+  }
+
+  __attribute__((target("avx2")))
+  static std::size_t skip_valid_utf8_avx2(const char* s, std::size_t n) noexcept
+  {
+    using namespace utf8_lookup;
+    const auto table_1_high = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(byte_1_high)));
+    const auto table_1_low = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(byte_1_low)));
+    const auto table_2_high = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(byte_2_high)));
+    const auto max_value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(incomplete_max + 32));
+    const auto low_nibble = _mm256_set1_epi8(0x0F);
+    auto prev_input = _mm256_setzero_si256();
+    auto prev_incomplete = _mm256_setzero_si256();
+    std::size_t i = 0;
+    for(; i + 32 <= n; i += 32){
+      auto input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+      __m256i error;
+      if(_mm256_movemask_epi8(input) == 0){
+        error = prev_incomplete;
+        prev_incomplete = _mm256_setzero_si256();
+      }else{
+        // note: alignr は 128 ビットのレーンごとに働くので，レーンをまたぐ部分を先に作っておく．
+        auto shifted = _mm256_permute2x128_si256(prev_input, input, 0x21);
+        auto prev1 = _mm256_alignr_epi8(input, shifted, 15);
+        auto prev2 = _mm256_alignr_epi8(input, shifted, 14);
+        auto prev3 = _mm256_alignr_epi8(input, shifted, 13);
+        auto special = _mm256_and_si256(
+          _mm256_and_si256(_mm256_shuffle_epi8(table_1_high, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), low_nibble)),
+                           _mm256_shuffle_epi8(table_1_low, _mm256_and_si256(prev1, low_nibble))),
+          _mm256_shuffle_epi8(table_2_high, _mm256_and_si256(_mm256_srli_epi16(input, 4), low_nibble)));
+        auto must23 = _mm256_or_si256(_mm256_subs_epu8(prev2, _mm256_set1_epi8(static_cast<char>(0xE0 - 0x80))),
+                                      _mm256_subs_epu8(prev3, _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80))));
+        error = _mm256_xor_si256(_mm256_and_si256(must23, _mm256_set1_epi8(static_cast<char>(0x80))), special);
+        prev_incomplete = _mm256_subs_epu8(input, max_value);
+      }
+      if(!_mm256_testz_si256(error, error)) break;
+      prev_input = input;
+    }
+    return back_to_char_boundary(s, i);
+  }
+
+  __attribute__((target("avx512f,avx512bw")))
+  static std::size_t skip_valid_utf8_avx512(const char* s, std::size_t n) noexcept
+  {
+    using namespace utf8_lookup;
+    const auto table_1_high = _mm512_maskz_broadcast_i32x4(0xFFFF, _mm_loadu_si128(reinterpret_cast<const __m128i*>(byte_1_high)));
+    const auto table_1_low = _mm512_maskz_broadcast_i32x4(0xFFFF, _mm_loadu_si128(reinterpret_cast<const __m128i*>(byte_1_low)));
+    const auto table_2_high = _mm512_maskz_broadcast_i32x4(0xFFFF, _mm_loadu_si128(reinterpret_cast<const __m128i*>(byte_2_high)));
+    const auto max_value = _mm512_loadu_si512(incomplete_max);
+    const auto low_nibble = _mm512_set1_epi8(0x0F);
+    const auto lane_shift = _mm512_set_epi64(13, 12, 11, 10, 9, 8, 7, 6);
+    auto prev_input = _mm512_setzero_si512();
+    auto prev_incomplete = _mm512_setzero_si512();
+    std::size_t i = 0;
+    for(; i + 64 <= n; i += 64){
+      auto input = _mm512_loadu_si512(s + i);
+      __m512i error;
+      if(_mm512_movepi8_mask(input) == 0){
+        error = prev_incomplete;
+        prev_incomplete = _mm512_setzero_si512();
+      }else{
+        auto shifted = _mm512_permutex2var_epi64(prev_input, lane_shift, input);
+        auto prev1 = _mm512_alignr_epi8(input, shifted, 15);
+        auto prev2 = _mm512_alignr_epi8(input, shifted, 14);
+        auto prev3 = _mm512_alignr_epi8(input, shifted, 13);
+        auto special = _mm512_and_si512(
+          _mm512_and_si512(_mm512_shuffle_epi8(table_1_high, _mm512_and_si512(_mm512_srli_epi16(prev1, 4), low_nibble)),
+                           _mm512_shuffle_epi8(table_1_low, _mm512_and_si512(prev1, low_nibble))),
+          _mm512_shuffle_epi8(table_2_high, _mm512_and_si512(_mm512_srli_epi16(input, 4), low_nibble)));
+        auto must23 = _mm512_or_si512(_mm512_subs_epu8(prev2, _mm512_set1_epi8(static_cast<char>(0xE0 - 0x80))),
+                                      _mm512_subs_epu8(prev3, _mm512_set1_epi8(static_cast<char>(0xF0 - 0x80))));
+        error = _mm512_xor_si512(_mm512_and_si512(must23, _mm512_set1_epi8(static_cast<char>(0x80))), special);
+        prev_incomplete = _mm512_subs_epu8(input, max_value);
+      }
+      if(_mm512_test_epi8_mask(error, error) != 0) break;
+      prev_input = input;
+    }
+    return back_to_char_boundary(s, i);
+  }
+
+  __attribute__((target("avx2")))
+  static bool is_ascii_avx2(const char* s, std::size_t n) noexcept
+  {
+    auto bits = _mm256_setzero_si256();
+    std::size_t i = 0;
+    for(; i + 128 <= n; i += 128){
+      bits = _mm256_or_si256(bits, _mm256_or_si256(
+        _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i)), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i + 32))),
+        _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i + 64)), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i + 96)))));
+      // note: 非 ASCII 文字を見つけたら早めに打ち切る．
+      if(_mm256_movemask_epi8(bits) != 0) return false;
+    }
+    for(; i + 32 <= n; i += 32){
+      bits = _mm256_or_si256(bits, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i)));
+    }
+    return _mm256_movemask_epi8(bits) == 0 && is_ascii_scalar(s + i, n - i);
+  }
+
+  __attribute__((target("avx512f,avx512bw")))
+  static bool is_ascii_avx512(const char* s, std::size_t n) noexcept
+  {
+    auto bits = _mm512_setzero_si512();
+    std::size_t i = 0;
+    for(; i + 256 <= n; i += 256){
+      bits = _mm512_or_si512(bits, _mm512_or_si512(
+        _mm512_or_si512(_mm512_loadu_si512(s + i), _mm512_loadu_si512(s + i + 64)),
+        _mm512_or_si512(_mm512_loadu_si512(s + i + 128), _mm512_loadu_si512(s + i + 192))));
+      if(_mm512_movepi8_mask(bits) != 0) return false;
+    }
+    for(; i + 64 <= n; i += 64){
+      bits = _mm512_or_si512(bits, _mm512_loadu_si512(s + i));
+    }
+    return _mm512_movepi8_mask(bits) == 0 && is_ascii_scalar(s + i, n - i);
+  }
+
+  // ダブルクォートの内側を表すマスクは，全ビットが 1 の値との繰り上がりのない乗算で求める．
+  __attribute__((target("pclmul,sse2")))
+  static inline std::uint64_t prefix_xor_clmul(std::uint64_t bits) noexcept
+  {
+    return static_cast<std::uint64_t>(_mm_cvtsi128_si64(_mm_clmulepi64_si128(_mm_set_epi64x(0, static_cast<long long>(bits)), _mm_set1_epi8(-1), 0)));
+  }
+
+  // note: 末尾の 64 バイトに満たない部分は，ゼロで埋めた一時領域に写して処理し，範囲外のビットを落とす．
+  static inline const char* tail_block(const char* s, std::size_t i, std::size_t n, char (&tail)[64], std::uint64_t& valid) noexcept
+  {
+    if(n - i >= 64){
+      valid = ~0ull;
+      return s + i;
+    }
+    std::memset(tail, 0, sizeof(tail));
+    std::memcpy(tail, s + i, n - i);
+    valid = (1ull << (n - i)) - 1;
+    return tail;
+  }
+
+  static std::size_t index_csv_structurals_sse2(const char* s, std::size_t n, char delimiter, char quote, bool& in_quote, std::uint32_t* positions) noexcept
+  {
+    const auto quotes = _mm_set1_epi8(quote);
+    const auto delim = _mm_set1_epi8(delimiter);
+    const auto line_feed = _mm_set1_epi8('\n');
+    std::uint64_t carry = in_quote ? ~0ull : 0;
+    auto out = positions;
+    char tail[64];
+    for(std::size_t i = 0; i < n; i += 64){
+      std::uint64_t valid;
+      auto block = tail_block(s, i, n, tail, valid);
+      std::uint64_t q = 0, d = 0, l = 0;
+      for(int k = 0; k < 4; ++k){
+        auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * k));
+        q |= static_cast<std::uint64_t>(static_cast<std::uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, quotes)))) << (16 * k);
+        d |= static_cast<std::uint64_t>(static_cast<std::uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, delim)))) << (16 * k);
+        l |= static_cast<std::uint64_t>(static_cast<std::uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, line_feed)))) << (16 * k);
+      }
+      q &= valid;
+      out = flatten_block(out, static_cast<std::uint32_t>(i), q, d & valid, l & valid, prefix_xor(q), carry);
+    }
+    in_quote = carry != 0;
+    return static_cast<std::size_t>(out - positions);
+  }
+
+  __attribute__((target("avx2,pclmul")))
+  static std::size_t index_csv_structurals_avx2(const char* s, std::size_t n, char delimiter, char quote, bool& in_quote, std::uint32_t* positions) noexcept
+  {
+    const auto quotes = _mm256_set1_epi8(quote);
+    const auto delim = _mm256_set1_epi8(delimiter);
+    const auto line_feed = _mm256_set1_epi8('\n');
+    std::uint64_t carry = in_quote ? ~0ull : 0;
+    auto out = positions;
+    char tail[64];
+    for(std::size_t i = 0; i < n; i += 64){
+      std::uint64_t valid;
+      auto block = tail_block(s, i, n, tail, valid);
+      auto lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+      auto hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+      auto mask = [](__m256i lo, __m256i hi, __m256i c) __attribute__((target("avx2"))) {
+        return static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, c))))
+          | static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, c)))) << 32;
+      };
+      auto q = mask(lo, hi, quotes) & valid;
+      out = flatten_block(out, static_cast<std::uint32_t>(i), q, mask(lo, hi, delim) & valid, mask(lo, hi, line_feed) & valid, prefix_xor_clmul(q), carry);
+    }
+    in_quote = carry != 0;
+    return static_cast<std::size_t>(out - positions);
+  }
+
+  __attribute__((target("avx512f,avx512bw,pclmul")))
+  static std::size_t index_csv_structurals_avx512(const char* s, std::size_t n, char delimiter, char quote, bool& in_quote, std::uint32_t* positions) noexcept
+  {
+    const auto quotes = _mm512_set1_epi8(quote);
+    const auto delim = _mm512_set1_epi8(delimiter);
+    const auto line_feed = _mm512_set1_epi8('\n');
+    std::uint64_t carry = in_quote ? ~0ull : 0;
+    auto out = positions;
+    for(std::size_t i = 0; i < n; i += 64){
+      // note: マスク付きのロードは範囲外のメモリに触れないので，末尾も一時領域に写す必要がない．
+      std::uint64_t valid = n - i >= 64 ? ~0ull : (1ull << (n - i)) - 1;
+      auto v = _mm512_maskz_loadu_epi8(valid, s + i);
+      std::uint64_t q = _mm512_mask_cmpeq_epi8_mask(valid, v, quotes);
+      std::uint64_t d = _mm512_mask_cmpeq_epi8_mask(valid, v, delim);
+      std::uint64_t l = _mm512_mask_cmpeq_epi8_mask(valid, v, line_feed);
+      out = flatten_block(out, static_cast<std::uint32_t>(i), q, d, l, prefix_xor_clmul(q), carry);
+    }
+    in_quote = carry != 0;
+    return static_cast<std::size_t>(out - positions);
+  }
+
+  // note: ダブルクォートを扱わないので，ブロック間で持ち越す状態がなく，prefix_xor も要らない．
+  static std::size_t index_csv_separators_sse2(const char* s, std::size_t n, char delimiter, std::uint32_t* positions) noexcept
+  {
+    const auto delim = _mm_set1_epi8(delimiter);
+    const auto line_feed = _mm_set1_epi8('\n');
+    auto out = positions;
+    std::size_t i = 0;
+    for(; i + 16 <= n; i += 16){
+      auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+      auto m = static_cast<std::uint16_t>(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, delim), _mm_cmpeq_epi8(v, line_feed))));
+      out = flatten_bits(out, static_cast<std::uint32_t>(i), m);
+    }
+    for(; i < n; ++i){
+      if(s[i] == delimiter || s[i] == '\n') *out++ = static_cast<std::uint32_t>(i);
+    }
+    return static_cast<std::size_t>(out - positions);
+  }
+
+  __attribute__((target("avx2")))
+  static std::size_t index_csv_separators_avx2(const char* s, std::size_t n, char delimiter, std::uint32_t* positions) noexcept
+  {
+    const auto delim = _mm256_set1_epi8(delimiter);
+    const auto line_feed = _mm256_set1_epi8('\n');
+    auto out = positions;
+    std::size_t i = 0;
+    for(; i + 32 <= n; i += 32){
+      auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+      auto m = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, delim), _mm256_cmpeq_epi8(v, line_feed))));
+      out = flatten_bits(out, static_cast<std::uint32_t>(i), m);
+    }
+    for(; i < n; ++i){
+      if(s[i] == delimiter || s[i] == '\n') *out++ = static_cast<std::uint32_t>(i);
+    }
+    return static_cast<std::size_t>(out - positions);
+  }
+
+  __attribute__((target("avx512f,avx512bw")))
+  static std::size_t index_csv_separators_avx512(const char* s, std::size_t n, char delimiter, std::uint32_t* positions) noexcept
+  {
+    const auto delim = _mm512_set1_epi8(delimiter);
+    const auto line_feed = _mm512_set1_epi8('\n');
+    auto out = positions;
+    for(std::size_t i = 0; i < n; i += 64){
+      std::uint64_t valid = n - i >= 64 ? ~0ull : (1ull << (n - i)) - 1;
+      auto v = _mm512_maskz_loadu_epi8(valid, s + i);
+      out = flatten_bits(out, static_cast<std::uint32_t>(i), _mm512_mask_cmpeq_epi8_mask(valid, v, delim) | _mm512_mask_cmpeq_epi8_mask(valid, v, line_feed));
+    }
+    return static_cast<std::size_t>(out - positions);
+  }
+
+  static bool needs_csv_quote_sse2(const char* s, std::size_t n, char delimiter) noexcept
+  {
+    const auto quote = _mm_set1_epi8('\"');
+    const auto delim = _mm_set1_epi8(delimiter);
+    const auto line_feed = _mm_set1_epi8('\n');
+    const auto carriage_return = _mm_set1_epi8('\r');
+    std::size_t i = 0;
+    for(; i + 16 <= n; i += 16){
+      auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+      auto m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, delim)), _mm_or_si128(_mm_cmpeq_epi8(v, line_feed), _mm_cmpeq_epi8(v, carriage_return)));
+      if(_mm_movemask_epi8(m) != 0) return true;
+    }
+    return needs_csv_quote_scalar(s + i, n - i, delimiter);
+  }
+
+  __attribute__((target("avx2")))
+  static bool needs_csv_quote_avx2(const char* s, std::size_t n, char delimiter) noexcept
+  {
+    const auto quote = _mm256_set1_epi8('\"');
+    const auto delim = _mm256_set1_epi8(delimiter);
+    const auto line_feed = _mm256_set1_epi8('\n');
+    const auto carriage_return = _mm256_set1_epi8('\r');
+    std::size_t i = 0;
+    for(; i + 32 <= n; i += 32){
+      auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+      auto m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, delim)),
+                               _mm256_or_si256(_mm256_cmpeq_epi8(v, line_feed), _mm256_cmpeq_epi8(v, carriage_return)));
+      if(_mm256_movemask_epi8(m) != 0) return true;
+    }
+    return needs_csv_quote_sse2(s + i, n - i, delimiter);
+  }
+
+  // note: 多くのフィールドは 64 バイトに満たないので，マスク付きのロードで 1 回の比較で済ませる．
+  __attribute__((target("avx512f,avx512bw")))
+  static bool needs_csv_quote_avx512(const char* s, std::size_t n, char delimiter) noexcept
+  {
+    const auto quote = _mm512_set1_epi8('\"');
+    const auto delim = _mm512_set1_epi8(delimiter);
+    const auto line_feed = _mm512_set1_epi8('\n');
+    const auto carriage_return = _mm512_set1_epi8('\r');
+    for(std::size_t i = 0; i < n; i += 64){
+      std::uint64_t valid = n - i >= 64 ? ~0ull : (1ull << (n - i)) - 1;
+      auto v = _mm512_maskz_loadu_epi8(valid, s + i);
+      auto m = _mm512_mask_cmpeq_epi8_mask(valid, v, quote) | _mm512_mask_cmpeq_epi8_mask(valid, v, delim)
+             | _mm512_mask_cmpeq_epi8_mask(valid, v, line_feed) | _mm512_mask_cmpeq_epi8_mask(valid, v, carriage_return);
+      if(m != 0) return true;
+    }
+    return false;
+  }
+
+#endif
+
+  using SkipFunction = std::size_t (*)(const char*, std::size_t) noexcept;
+
+  static SkipFunction select_skip_valid_utf8() noexcept
+  {
+#ifdef ACCIO_CORE_SIMD_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512bw")) return skip_valid_utf8_avx512;
+    if(__builtin_cpu_supports("avx2")) return skip_valid_utf8_avx2;
+    if(__builtin_cpu_supports("ssse3")) return skip_valid_utf8_ssse3;
+#endif
+    return skip_valid_utf8_scalar;
+  }
+
+  std::size_t skip_valid_utf8(const char* s, std::size_t n) noexcept
+  {
+    static const SkipFunction f = select_skip_valid_utf8();
+    return f(s, n);
+  }
+
+  using IsAsciiFunction = bool (*)(const char*, std::size_t) noexcept;
+
+  static IsAsciiFunction select_is_ascii() noexcept
+  {
+#ifdef ACCIO_CORE_SIMD_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512bw")) return is_ascii_avx512;
+    if(__builtin_cpu_supports("avx2")) return is_ascii_avx2;
+#endif
+    // note: SSE2 までの範囲であれば，8 バイト単位の判定でもコンパイラの自動ベクトル化で十分な速度が出る．
+    return is_ascii_scalar;
+  }
+
+  bool is_ascii(const char* s, std::size_t n) noexcept
+  {
+    static const IsAsciiFunction f = select_is_ascii();
+    return f(s, n);
+  }
+
+  using IndexFunction = std::size_t (*)(const char*, std::size_t, char, char, bool&, std::uint32_t*) noexcept;
+
+  static IndexFunction select_index_csv_structurals() noexcept
+  {
+#ifdef ACCIO_CORE_SIMD_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("pclmul")) return index_csv_structurals_avx512;
+    if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("pclmul")) return index_csv_structurals_avx2;
+    return index_csv_structurals_sse2;
+#else
+    return index_csv_structurals_scalar;
+#endif
+  }
+
+  std::size_t index_csv_structurals(const char* s, std::size_t n, char delimiter, char quote, bool& in_quote, std::uint32_t* positions) noexcept
+  {
+    static const IndexFunction f = select_index_csv_structurals();
+    return f(s, n, delimiter, quote, in_quote, positions);
+  }
+
+  using SeparatorFunction = std::size_t (*)(const char*, std::size_t, char, std::uint32_t*) noexcept;
+
+  static SeparatorFunction select_index_csv_separators() noexcept
+  {
+#ifdef ACCIO_CORE_SIMD_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512bw")) return index_csv_separators_avx512;
+    if(__builtin_cpu_supports("avx2")) return index_csv_separators_avx2;
+    return index_csv_separators_sse2;
+#else
+    return index_csv_separators_scalar;
+#endif
+  }
+
+  std::size_t index_csv_separators(const char* s, std::size_t n, char delimiter, std::uint32_t* positions) noexcept
+  {
+    static const SeparatorFunction f = select_index_csv_separators();
+    return f(s, n, delimiter, positions);
+  }
+
+  using NeedsQuoteFunction = bool (*)(const char*, std::size_t, char) noexcept;
+
+  static NeedsQuoteFunction select_needs_csv_quote() noexcept
+  {
+#ifdef ACCIO_CORE_SIMD_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512bw")) return needs_csv_quote_avx512;
+    if(__builtin_cpu_supports("avx2")) return needs_csv_quote_avx2;
+    return needs_csv_quote_sse2;
+#else
+    return needs_csv_quote_scalar;
+#endif
+  }
+
+  bool needs_csv_quote(const char* s, std::size_t n, char delimiter) noexcept
+  {
+    static const NeedsQuoteFunction f = select_needs_csv_quote();
+    return f(s, n, delimiter);
+  }
+
+}
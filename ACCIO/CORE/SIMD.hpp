@@ -0,0 +1,40 @@
+#ifndef ACCIO_CORE_SIMD_HPP_
+#define ACCIO_CORE_SIMD_HPP_
+
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace ACCIO::CORE
+{
+
+  /// index_csv_structurals() と index_csv_separators() が positions の末尾を越えて書き込みうる要素数．
+  constexpr std::size_t index_padding = 8;
+
+  // note: 以下の関数は実行時に CPU が対応している命令セット（AVX-512BW, AVX2, SSSE3）を判定して実装を切り替える．
+
+  /// [s, s + n) の先頭から，妥当な UTF-8 文字列であると SIMD 命令で確認できたバイト数を返す．
+  /// 返り値は常に文字の境界である．残りの部分（末尾の端数や不正なバイト列の位置の特定）の検証は呼び出し側が行う．
+  std::size_t skip_valid_utf8(const char* s, std::size_t n) noexcept;
+
+  /// [s, s + n) が ASCII 文字のみからなる場合に true を返す．
+  bool is_ascii(const char* s, std::size_t n) noexcept;
+
+  /// [s, s + n) に含まれる CSV の構造文字の位置（s からのオフセット）を昇順に positions に書き込み，その個数を返す．
+  /// 構造文字とは，すべての囲み文字（quote，通常はダブルクォート）と，囲み文字で囲まれていない区切り文字および LF である．
+  /// in_quote は走査開始時に囲み文字の内側にいるか否かを表し，走査後の状態に更新される．
+  /// positions には n + index_padding 要素以上の領域が必要である．
+  std::size_t index_csv_structurals(const char* s, std::size_t n, char delimiter, char quote, bool& in_quote, std::uint32_t* positions) noexcept;
+
+  /// [s, s + n) に含まれる区切り文字および LF の位置を昇順に positions に書き込み，その個数を返す．囲み文字を使わない方言に用いる．
+  /// positions には n + index_padding 要素以上の領域が必要である．
+  std::size_t index_csv_separators(const char* s, std::size_t n, char delimiter, std::uint32_t* positions) noexcept;
+
+  /// [s, s + n) が CSV のフィールドとしてダブルクォートで囲む必要のある文字（ダブルクォート，区切り文字，CR，LF）を含む場合に true を返す．
+  bool needs_csv_quote(const char* s, std::size_t n, char delimiter) noexcept;
+
+}
+
+
+#endif
@@ -0,0 +1,241 @@
+#ifndef ACCIO_CORE_STATISTICS_HPP_
+#define ACCIO_CORE_STATISTICS_HPP_
+
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include "AlignedBuffer.hpp"
+
+
+// note: ACCIO_ENABLE_STATISTICS を定義してコンパイルした場合のみ計測する．定義しない場合は以下のマクロは何も生成しない．
+// 計測値はプロセス全体で共有し，すべての翻訳単位を同じ設定でコンパイルする必要がある．
+// レコードごとの計測値は ACCIO_STATISTICS_LOCAL_ADD 等で解析器ごとの LocalCounters に溜め，ACCIO_STATISTICS_FLUSH でまとめて加える．
+#ifdef ACCIO_ENABLE_STATISTICS
+#define ACCIO_STATISTICS_ADD(name, n) (::ACCIO::CORE::STATISTICS::counters.name.fetch_add(static_cast<std::uint64_t>(n), std::memory_order_relaxed))
+#define ACCIO_STATISTICS_MAX(name, n) (::ACCIO::CORE::STATISTICS::update_max(::ACCIO::CORE::STATISTICS::counters.name, static_cast<std::uint64_t>(n)))
+#define ACCIO_STATISTICS_TIMER(name) ::ACCIO::CORE::STATISTICS::ScopedTimer accio_statistics_timer_##name(::ACCIO::CORE::STATISTICS::counters.name)
+#define ACCIO_STATISTICS_LOCAL_ADD(local, name, n) static_cast<void>((local).name += static_cast<std::uint64_t>(n))
+#define ACCIO_STATISTICS_LOCAL_MAX(local, name, n) static_cast<void>((local).name = std::max<std::uint64_t>((local).name, static_cast<std::uint64_t>(n)))
+#define ACCIO_STATISTICS_FLUSH(local) ((local).flush())
+#define ACCIO_STATISTICS_CODE(...) __VA_ARGS__
+#else
+#define ACCIO_STATISTICS_ADD(name, n) static_cast<void>(0)
+#define ACCIO_STATISTICS_MAX(name, n) static_cast<void>(0)
+#define ACCIO_STATISTICS_TIMER(name) static_cast<void>(0)
+#define ACCIO_STATISTICS_LOCAL_ADD(local, name, n) static_cast<void>(0)
+#define ACCIO_STATISTICS_LOCAL_MAX(local, name, n) static_cast<void>(0)
+#define ACCIO_STATISTICS_FLUSH(local) static_cast<void>(0)
+#define ACCIO_STATISTICS_CODE(...)
+#endif
+
+
+namespace ACCIO::CORE
+{
+
+  /// 計測値．時間はナノ秒単位．
+  struct Statistics
+  {
+    // BinaryReader
+    std::uint64_t read_calls = 0;
+    std::uint64_t bytes_read = 0;
+    std::uint64_t map_calls = 0;
+    std::uint64_t bytes_mapped = 0;
+    // 先読みするリーダーが読み込みの完了を待った時間．
+    std::uint64_t read_wait_ns = 0;
+    // デコーダ
+    std::uint64_t decoded_bytes = 0;
+    std::uint64_t decode_ns = 0;
+    // InputStream
+    std::uint64_t refills = 0;
+    std::uint64_t refill_ns = 0;
+    // CSVParser
+    std::uint64_t records = 0;
+    std::uint64_t fields = 0;
+    std::uint64_t quoted_fields = 0;
+    // 改行を含むレコードの長さ（要素数）の最大値．ブロック単位で解析する場合（BlockImpl）のみ計測する．
+    std::uint64_t max_record_size = 0;
+
+    std::string to_json() const
+    {
+      std::string result = "{";
+      auto add = [&](const char* name, std::uint64_t value){
+        if(result.size() > 1) result += ", ";
+        result += '"';
+        result += name;
+        result += "\": ";
+        result += std::to_string(value);
+      };
+      add("read_calls", read_calls);
+      add("bytes_read", bytes_read);
+      add("map_calls", map_calls);
+      add("bytes_mapped", bytes_mapped);
+      add("read_wait_ns", read_wait_ns);
+      add("decoded_bytes", decoded_bytes);
+      add("decode_ns", decode_ns);
+      add("refills", refills);
+      add("refill_ns", refill_ns);
+      add("records", records);
+      add("fields", fields);
+      add("quoted_fields", quoted_fields);
+      add("max_record_size", max_record_size);
+      result += "}";
+      return result;
+    }
+
+  };
+
+  namespace STATISTICS
+  {
+
+    // note: 複数のスレッドが更新するので，各計測値を別のキャッシュラインに置く．
+    struct Counters
+    {
+      alignas(cache_line_size) std::atomic<std::uint64_t> read_calls{0};
+      alignas(cache_line_size) std::atomic<std::uint64_t> bytes_read{0};
+      alignas(cache_line_size) std::atomic<std::uint64_t> map_calls{0};
+      alignas(cache_line_size) std::atomic<std::uint64_t> bytes_mapped{0};
+      alignas(cache_line_size) std::atomic<std::uint64_t> read_wait_ns{0};
+      alignas(cache_line_size) std::atomic<std::uint64_t> decoded_bytes{0};
+      alignas(cache_line_size) std::atomic<std::uint64_t> decode_ns{0};
+      alignas(cache_line_size) std::atomic<std::uint64_t> refills{0};
+      alignas(cache_line_size) std::atomic<std::uint64_t> refill_ns{0};
+      alignas(cache_line_size) std::atomic<std::uint64_t> records{0};
+      alignas(cache_line_size) std::atomic<std::uint64_t> fields{0};
+      alignas(cache_line_size) std::atomic<std::uint64_t> quoted_fields{0};
+      alignas(cache_line_size) std::atomic<std::uint64_t> max_record_size{0};
+    };
+
+    inline Counters counters;
+
+    inline void update_max(std::atomic<std::uint64_t>& counter, std::uint64_t value) noexcept
+    {
+      auto current = counter.load(std::memory_order_relaxed);
+      while(current < value && !counter.compare_exchange_weak(current, value, std::memory_order_relaxed));
+    }
+
+    // 1 つの解析器が解析したレコードの計測値．レコードごとに共有の counters を更新せずにここに溜め，flush() でまとめて加える．
+    class LocalCounters
+    {
+    public:
+
+      std::uint64_t records = 0;
+      std::uint64_t fields = 0;
+      std::uint64_t quoted_fields = 0;
+      std::uint64_t max_record_size = 0;
+
+      LocalCounters() = default;
+
+      LocalCounters(LocalCounters&& other) noexcept:
+        records(std::exchange(other.records, 0)), fields(std::exchange(other.fields, 0)),
+        quoted_fields(std::exchange(other.quoted_fields, 0)), max_record_size(std::exchange(other.max_record_size, 0))
+      {}
+
+      ~LocalCounters() noexcept
+      {
+        flush();
+      }
+
+      void flush() noexcept
+      {
+        if(records != 0){
+          counters.records.fetch_add(records, std::memory_order_relaxed);
+          counters.fields.fetch_add(fields, std::memory_order_relaxed);
+          records = 0;
+          fields = 0;
+        }
+        if(quoted_fields != 0){
+          counters.quoted_fields.fetch_add(quoted_fields, std::memory_order_relaxed);
+          quoted_fields = 0;
+        }
+        if(max_record_size != 0){
+          update_max(counters.max_record_size, max_record_size);
+          max_record_size = 0;
+        }
+      }
+
+    // deleted:
+
+      LocalCounters(const LocalCounters&) = delete;
+      LocalCounters& operator=(LocalCounters&&) = delete;
+      LocalCounters& operator=(const LocalCounters&) = delete;
+
+    };
+
+    // スコープを抜けるまでの時間を counter に加える．
+    class ScopedTimer
+    {
+    private:
+
+      std::atomic<std::uint64_t>& counter_;
+      std::chrono::steady_clock::time_point start_;
+
+    public:
+
+      explicit ScopedTimer(std::atomic<std::uint64_t>& counter) noexcept:
+        counter_(counter), start_(std::chrono::steady_clock::now())
+      {}
+
+      ~ScopedTimer() noexcept
+      {
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count();
+        counter_.fetch_add(static_cast<std::uint64_t>(elapsed), std::memory_order_relaxed);
+      }
+
+    // deleted:
+
+      ScopedTimer(ScopedTimer&&) = delete;
+      ScopedTimer(const ScopedTimer&) = delete;
+      ScopedTimer& operator=(ScopedTimer&&) = delete;
+      ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    };
+
+  }
+
+  /// 計測しているかを表す．
+#ifdef ACCIO_ENABLE_STATISTICS
+  inline constexpr bool statistics_enabled = true;
+#else
+  inline constexpr bool statistics_enabled = false;
+#endif
+
+  /// 現在の計測値を返す．計測していない場合はすべて 0 となる．
+  /// note: 解析中の解析器のレコードの計測値は，入力のウィンドウを進めたときと解析器を破棄したときに加わる．
+  inline Statistics statistics() noexcept
+  {
+    Statistics result;
+    const auto& c = STATISTICS::counters;
+    result.read_calls = c.read_calls.load(std::memory_order_relaxed);
+    result.bytes_read = c.bytes_read.load(std::memory_order_relaxed);
+    result.map_calls = c.map_calls.load(std::memory_order_relaxed);
+    result.bytes_mapped = c.bytes_mapped.load(std::memory_order_relaxed);
+    result.read_wait_ns = c.read_wait_ns.load(std::memory_order_relaxed);
+    result.decoded_bytes = c.decoded_bytes.load(std::memory_order_relaxed);
+    result.decode_ns = c.decode_ns.load(std::memory_order_relaxed);
+    result.refills = c.refills.load(std::memory_order_relaxed);
+    result.refill_ns = c.refill_ns.load(std::memory_order_relaxed);
+    result.records = c.records.load(std::memory_order_relaxed);
+    result.fields = c.fields.load(std::memory_order_relaxed);
+    result.quoted_fields = c.quoted_fields.load(std::memory_order_relaxed);
+    result.max_record_size = c.max_record_size.load(std::memory_order_relaxed);
+    return result;
+  }
+
+  /// 計測値を 0 に戻す．
+  inline void reset_statistics() noexcept
+  {
+    auto& c = STATISTICS::counters;
+    for(auto* counter: {&c.read_calls, &c.bytes_read, &c.map_calls, &c.bytes_mapped, &c.read_wait_ns, &c.decoded_bytes, &c.decode_ns,
+                        &c.refills, &c.refill_ns, &c.records, &c.fields, &c.quoted_fields, &c.max_record_size}){
+      counter->store(0, std::memory_order_relaxed);
+    }
+  }
+
+}
+
+
+#endif
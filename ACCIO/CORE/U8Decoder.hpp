@@ -0,0 +1,390 @@
+#ifndef ACCIO_CORE_U8DECODER_HPP_
+#define ACCIO_CORE_U8DECODER_HPP_
+
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include <type_traits>
+#include "Reader.hpp"
+#include "SIMD.hpp"
+#include "Statistics.hpp"
+
+
+// note: make_decoder は型消去された Reader を返すが，以下のクラスを直接使えば読み込み元の型を固定した Reader を合成できる．
+// BinaryReaderPtrT には BinaryReader の派生クラスを指す std::unique_ptr または std::shared_ptr を指定する．
+// 派生クラスが final であれば，読み込み元の呼び出しは仮想関数呼び出しを介さない．
+
+
+namespace ACCIO::CORE
+{
+
+  // s から始まる UTF-8 の 1 文字を検証し，妥当かどうかとバイト数を返す．
+  inline std::tuple<bool, unsigned> parse_u8char(const char* s) noexcept
+  {
+    const std::uint8_t* t = reinterpret_cast<const std::uint8_t*>(s);
+    if(t[0] <= 0x7F){
+      return {true, 1};
+    }else if(0xC2 <= t[0] && t[0] <= 0xDF){
+      if(0x80 <= t[1] && t[1] <= 0xBF) return {true, 2};
+      else return {false, 2};
+    }else if(t[0] == 0xE0){
+      if(0xA0 <= t[1] && t[1] <= 0xBF){
+        if(0x80 <= t[2] && t[2] <= 0xBF) return {true, 3};
+        else return {false, 3};
+      }else return {false, 2};
+    }else if(0xE1 <= t[0] && t[0] <= 0xEC){
+      if(0x80 <= t[1] && t[1] <= 0xBF){
+        if(0x80 <= t[2] && t[2] <= 0xBF) return {true, 3};
+        else return {false, 3};
+      }else return {false, 2};
+    }else if(t[0] == 0xED){
+      if(0x80 <= t[1] && t[1] <= 0x9F){
+        if(0x80 <= t[2] && t[2] <= 0xBF) return {true, 3};
+        else return {false, 3};
+      }else return {false, 2};
+    }else if(0xEE <= t[0] && t[0] <= 0xEF){
+      if(0x80 <= t[1] && t[1] <= 0xBF){
+        if(0x80 <= t[2] && t[2] <= 0xBF) return {true, 3};
+        else return {false, 3};
+      }else return {false, 2};
+    }else if(t[0] == 0xF0){
+      if(0x90 <= t[1] && t[1] <= 0xBF){
+        if(0x80 <= t[2] && t[2] <= 0xBF){
+          if(0x80 <= t[3] && t[3] <= 0xBF) return {true, 4};
+          else return {false, 4}; 
+        }else return {false, 3};
+      }else return {false, 2};
+    }else if(0xF1 <= t[0] && t[0] <= 0xF3){
+      if(0x80 <= t[1] && t[1] <= 0xBF){
+        if(0x80 <= t[2] && t[2] <= 0xBF){
+          if(0x80 <= t[3] && t[3] <= 0xBF) return {true, 4};
+          else return {false, 4};
+        }else return {false, 3};
+      }else return {false, 2};
+    }else if(t[0] == 0xF4){
+      if(0x80 <= t[1] && t[1] <= 0x8F){
+        if(0x80 <= t[2] && t[2] <= 0xBF){
+          if(0x80 <= t[3] && t[3] <= 0xBF) return {true, 4};
+          else return {false, 4};
+        }else return {false, 3};
+      }else return {false, 2};
+    }else return {false, 1};
+  }
+
+
+  // 先頭バイトから UTF-8 の 1 文字のバイト数を求める．先頭バイトとして不正な場合は 1 を返す．
+  inline unsigned u8char_length(char c) noexcept
+  {
+    auto t = static_cast<std::uint8_t>(c);
+    if(t <= 0x7F) return 1;
+    else if(0xC2 <= t && t <= 0xDF) return 2;
+    else if(0xE0 <= t && t <= 0xEF) return 3;
+    else if(0xF0 <= t && t <= 0xF4) return 4;
+    else return 1;
+  }
+
+  // [s, s + n) の先頭から続く妥当な UTF-8 文字列のバイト数を返す．末尾の不完全な文字は含まない．
+  // 不正なバイト列を検出した場合は例外を送出する．
+  inline std::size_t validate_utf8(const char* s, std::size_t n)
+  {
+    std::size_t i = skip_valid_utf8(s, n);
+    while(i < n){
+      // note: parse_u8char が領域外を読まないように，先に文字の長さを確認する．
+      if(u8char_length(s[i]) > n - i) break;
+      auto [is_valid, bytes] = parse_u8char(s + i);
+      if(!is_valid) throw std::runtime_error("Invalid encoding");
+      i += bytes;
+    }
+    return i;
+  }
+
+  template<class BinaryReaderPtrT>
+  class U8DecoderFromAscii final: public U8Reader
+  {
+    static_assert(std::is_base_of_v<BinaryReader, typename BinaryReaderPtrT::element_type>);
+  private:
+
+    BinaryReaderPtrT binary_reader_;
+
+  public:
+
+    template<class T>
+    explicit U8DecoderFromAscii(T&& binary_reader):
+      binary_reader_(std::forward<T>(binary_reader))
+    {}
+
+    std::size_t min_buffer_size() const noexcept override
+    {
+      if(binary_reader_ != nullptr){
+        return binary_reader_->min_buffer_size();
+      }else{
+        return 0;
+      }
+    }
+
+    std::size_t preferred_buffer_size() const noexcept override
+    {
+      if(binary_reader_ != nullptr){
+        return binary_reader_->preferred_buffer_size();
+      }else{
+        return 0;
+      }
+    }
+
+    std::size_t operator()(char_type* buffer, std::size_t limit) override
+    {
+      if(binary_reader_ != nullptr){
+        auto n = (*binary_reader_)(reinterpret_cast<char*>(buffer), limit);
+        ACCIO_STATISTICS_TIMER(decode_ns);
+        if(!is_ascii(reinterpret_cast<const char*>(buffer), n)) throw std::runtime_error("not ascii.");
+        ACCIO_STATISTICS_ADD(decoded_bytes, n);
+        return n;
+      }else{
+        return 0;
+      }
+    }
+
+    bool mappable() const noexcept override
+    {
+      return binary_reader_ != nullptr && binary_reader_->mappable();
+    }
+
+    std::tuple<const char_type*, std::size_t> map(std::size_t limit) override
+    {
+      if(binary_reader_ != nullptr){
+        auto [first, n] = binary_reader_->map(limit);
+        ACCIO_STATISTICS_TIMER(decode_ns);
+        if(!is_ascii(first, n)) throw std::runtime_error("not ascii.");
+        ACCIO_STATISTICS_ADD(decoded_bytes, n);
+        return {reinterpret_cast<const char_type*>(first), n};
+      }else{
+        return {nullptr, 0};
+      }
+    }
+
+    void close() noexcept override
+    {
+      binary_reader_ = nullptr;
+    }
+
+  };
+
+  // 検証を行わずにそのまま受け渡す（"binary", "trusted-utf-8"）．
+  template<class BinaryReaderPtrT>
+  class U8DecoderPassThrough final: public U8Reader
+  {
+    static_assert(std::is_base_of_v<BinaryReader, typename BinaryReaderPtrT::element_type>);
+  private:
+
+    BinaryReaderPtrT binary_reader_;
+
+  public:
+
+    template<class T>
+    explicit U8DecoderPassThrough(T&& binary_reader):
+      binary_reader_(std::forward<T>(binary_reader))
+    {}
+
+    std::size_t min_buffer_size() const noexcept override
+    {
+      if(binary_reader_ != nullptr){
+        return binary_reader_->min_buffer_size();
+      }else{
+        return 0;
+      }
+    }
+
+    std::size_t preferred_buffer_size() const noexcept override
+    {
+      if(binary_reader_ != nullptr){
+        return binary_reader_->preferred_buffer_size();
+      }else{
+        return 0;
+      }
+    }
+
+    std::size_t operator()(char_type* buffer, std::size_t limit) override
+    {
+      if(binary_reader_ != nullptr){
+        auto n = (*binary_reader_)(reinterpret_cast<char*>(buffer), limit);
+        ACCIO_STATISTICS_ADD(decoded_bytes, n);
+        return n;
+      }else{
+        return 0;
+      }
+    }
+
+    bool mappable() const noexcept override
+    {
+      return binary_reader_ != nullptr && binary_reader_->mappable();
+    }
+
+    std::tuple<const char_type*, std::size_t> map(std::size_t limit) override
+    {
+      if(binary_reader_ != nullptr){
+        auto [first, n] = binary_reader_->map(limit);
+        ACCIO_STATISTICS_ADD(decoded_bytes, n);
+        return {reinterpret_cast<const char_type*>(first), n};
+      }else{
+        return {nullptr, 0};
+      }
+    }
+
+    void close() noexcept override
+    {
+      binary_reader_ = nullptr;
+    }
+
+  };
+
+  template<class BinaryReaderPtrT>
+  class U8DecoderFromUTF8 final: public U8Reader
+  {
+    static_assert(std::is_base_of_v<BinaryReader, typename BinaryReaderPtrT::element_type>);
+
+  private:
+
+    BinaryReaderPtrT binary_reader_;
+    std::size_t min_buffer_size_;
+    std::size_t frag_size_;
+    char_type frag_buffer_[4];
+    // map() で binary_reader_ から受け取った領域のうち，まだ返していない部分．
+    const char* rest_;
+    std::size_t rest_size_;
+
+  public:
+
+    template<class T>
+    explicit U8DecoderFromUTF8(T&& binary_reader):
+      binary_reader_(std::forward<T>(binary_reader)), min_buffer_size_(binary_reader_->min_buffer_size() + 6), frag_size_(0), frag_buffer_(),
+      rest_(nullptr), rest_size_(0)
+    {}
+
+    std::size_t min_buffer_size() const noexcept override
+    {
+      return min_buffer_size_;
+    }
+
+    std::size_t preferred_buffer_size() const noexcept override
+    {
+      if(binary_reader_ != nullptr){
+        // note: min_buffer_size_ と同様に，持ち越した文字と番兵の分を加える．
+        return std::max(binary_reader_->preferred_buffer_size() + 6, min_buffer_size_);
+      }else{
+        return 0;
+      }
+    }
+
+    std::size_t operator()(char_type* buffer, std::size_t limit) override
+    {
+      if(binary_reader_ != nullptr){
+        assert(limit >= min_buffer_size_);
+        for(std::uint8_t i = 0; i < frag_size_; ++i){
+          buffer[i] = frag_buffer_[i];
+        }
+        //
+        auto m = (*binary_reader_)(reinterpret_cast<char*>(buffer) + frag_size_, limit - frag_size_ - 3);
+        auto n = m + frag_size_;
+        frag_size_ = 0;
+        //
+        if(n == 0) return 0;
+        // note: 読み込みの時間を含めないように，ここから検証の時間を測る．
+        ACCIO_STATISTICS_TIMER(decode_ns);
+        //
+        assert(n + 3 <= limit);
+        buffer[n] = 0;
+        buffer[n + 1] = 0;
+        buffer[n + 2] = 0;
+        //
+        auto [is_valid, bytes] = parse_u8char(reinterpret_cast<const char*>(buffer));
+        if(!is_valid) throw std::runtime_error("Invalid encoding");
+        //
+        assert(bytes <= n);
+        // note: SIMD 命令で妥当と確認できた部分を読み飛ばし，残りを 1 文字ずつ検証する．
+        for(std::size_t i = std::max<std::size_t>(bytes, skip_valid_utf8(reinterpret_cast<const char*>(buffer), n)); i < n;){
+          auto [is_valid, bytes] = parse_u8char(reinterpret_cast<const char*>(buffer) + i);
+          if(is_valid){
+            i += bytes;
+            assert(i <= n);
+          }else{
+            frag_size_ = std::min<std::size_t>(bytes, n - i);
+            for(std::size_t j = 0; j < frag_size_; ++j){
+              frag_buffer_[j] = buffer[i + j];
+            }
+            ACCIO_STATISTICS_ADD(decoded_bytes, i);
+            return i;
+          }
+        }
+        ACCIO_STATISTICS_ADD(decoded_bytes, n);
+        return n;
+      }else{
+        return 0;
+      }
+    }
+
+    bool mappable() const noexcept override
+    {
+      return binary_reader_ != nullptr && binary_reader_->mappable();
+    }
+
+    std::tuple<const char_type*, std::size_t> map(std::size_t limit) override
+    {
+      if(binary_reader_ == nullptr) return {nullptr, 0};
+      while(true){
+        if(rest_size_ == 0){
+          auto [first, n] = binary_reader_->map(limit);
+          rest_ = first;
+          rest_size_ = n;
+          if(n == 0){
+            if(frag_size_ != 0) throw std::runtime_error("Invalid encoding");
+            return {nullptr, 0};
+          }
+        }
+        if(frag_size_ != 0){
+          // 領域の境界をまたいだ文字は frag_buffer_ 上で組み立てて，その 1 文字だけを返す．
+          auto length = u8char_length(frag_buffer_[0]);
+          while(frag_size_ < length && rest_size_ > 0){
+            frag_buffer_[frag_size_++] = *rest_++;
+            --rest_size_;
+          }
+          if(frag_size_ < length) continue;
+          auto [is_valid, bytes] = parse_u8char(reinterpret_cast<const char*>(frag_buffer_));
+          if(!is_valid) throw std::runtime_error("Invalid encoding");
+          assert(bytes == frag_size_);
+          frag_size_ = 0;
+          ACCIO_STATISTICS_ADD(decoded_bytes, bytes);
+          return {frag_buffer_, bytes};
+        }
+        std::size_t n;
+        {
+          ACCIO_STATISTICS_TIMER(decode_ns);
+          n = validate_utf8(rest_, rest_size_);
+        }
+        auto first = reinterpret_cast<const char_type*>(rest_);
+        // 末尾の不完全な文字は次の呼び出しに持ち越す．
+        for(std::size_t i = n; i < rest_size_; ++i){
+          frag_buffer_[frag_size_++] = rest_[i];
+        }
+        rest_ = nullptr;
+        rest_size_ = 0;
+        ACCIO_STATISTICS_ADD(decoded_bytes, n);
+        if(n != 0) return {first, n};
+      }
+    }
+
+    void close() noexcept override
+    {
+      binary_reader_ = nullptr;
+      min_buffer_size_ = 0;
+      frag_size_ = 0;
+      rest_ = nullptr;
+      rest_size_ = 0;
+    }
+
+  };
+
+}
+
+
+#endif
@@ -0,0 +1,361 @@
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <vector>
+#include "BinaryFDReader.hpp"
+#include "Statistics.hpp"
+#include "UringReader.hpp"
+
+
+namespace ACCIO::CORE
+{
+
+  class BinaryUringReader final: public BinaryReader
+  {
+  private:
+
+    // note: O_DIRECT の制約を満たすため，バッファの先頭と大きさをこの値の倍数に揃える．
+    static constexpr std::size_t alignment = 4096;
+
+    struct Slot
+    {
+      char* buffer_;
+      ::iovec iovec_;
+      std::size_t offset_;
+      std::size_t expected_;
+      int result_;
+      bool pending_;
+    };
+
+    int fd_;
+    int ring_fd_;
+    void* sq_ring_;
+    std::size_t sq_ring_size_;
+    void* cq_ring_;
+    std::size_t cq_ring_size_;
+    ::io_uring_sqe* sqes_;
+    std::size_t sqes_size_;
+    unsigned* sq_tail_;
+    unsigned* sq_mask_;
+    unsigned* sq_array_;
+    unsigned* cq_head_;
+    unsigned* cq_tail_;
+    unsigned* cq_mask_;
+    ::io_uring_cqe* cqes_;
+    bool registered_;
+    std::size_t file_size_;
+    std::size_t buffer_size_;
+    char* buffers_;
+    std::vector<Slot> slots_;
+    std::size_t next_offset_;
+    unsigned to_submit_;
+    std::size_t in_flight_;
+    // 利用側の状態．slots_ はファイルの先頭から順に巡回的に使われる．
+    std::size_t current_index_;
+    bool holding_;
+    const char* current_;
+    std::size_t current_size_;
+
+    int enter(unsigned to_submit, unsigned min_complete)
+    {
+      while(true){
+        auto ret = ::syscall(__NR_io_uring_enter, ring_fd_, to_submit, min_complete, min_complete > 0 ? IORING_ENTER_GETEVENTS : 0u, nullptr, 0);
+        if(ret >= 0) return static_cast<int>(ret);
+        if(errno != EINTR) throw std::runtime_error("io_uring_enter() failure.");
+      }
+    }
+
+    void push(std::size_t index, std::size_t offset)
+    {
+      auto& slot = slots_[index];
+      slot.offset_ = offset;
+      slot.expected_ = offset < file_size_ ? std::min(buffer_size_, file_size_ - offset) : 0;
+      slot.result_ = 0;
+      if(slot.expected_ == 0) return;  // EOF 以降は読み込む必要がない．
+      auto tail = *sq_tail_;
+      auto sqe_index = tail & *sq_mask_;
+      auto& sqe = sqes_[sqe_index];
+      std::memset(&sqe, 0, sizeof(sqe));
+      sqe.fd = fd_;
+      sqe.off = slot.offset_;
+      sqe.user_data = index;
+      if(registered_){
+        sqe.opcode = IORING_OP_READ_FIXED;
+        sqe.addr = reinterpret_cast<std::uintptr_t>(slot.buffer_);
+        sqe.len = static_cast<unsigned>(buffer_size_);
+        sqe.buf_index = static_cast<std::uint16_t>(index);
+      }else{
+        sqe.opcode = IORING_OP_READV;
+        sqe.addr = reinterpret_cast<std::uintptr_t>(&slot.iovec_);
+        sqe.len = 1;
+      }
+      sq_array_[sqe_index] = sqe_index;
+      __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+      slot.pending_ = true;
+      ++to_submit_;
+      ++in_flight_;
+    }
+
+    void reap() noexcept
+    {
+      auto head = *cq_head_;
+      auto tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+      for(; head != tail; ++head){
+        const auto& cqe = cqes_[head & *cq_mask_];
+        auto& slot = slots_[cqe.user_data];
+        slot.result_ = cqe.res;
+        slot.pending_ = false;
+        --in_flight_;
+      }
+      __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    }
+
+    void wait(std::size_t index)
+    {
+      if(to_submit_ > 0){
+        to_submit_ -= enter(to_submit_, 0);
+      }
+      while(true){
+        reap();
+        if(!slots_[index].pending_) return;
+        to_submit_ -= enter(to_submit_, 1);
+      }
+    }
+
+    void release() noexcept
+    {
+      // note: 発行済みの読み込みが完了する前にバッファを解放してはならない．
+      bool drained = true;
+      if(ring_fd_ >= 0){
+        try{
+          while(in_flight_ > 0){
+            enter(to_submit_, 1);
+            to_submit_ = 0;
+            reap();
+          }
+        }catch(const std::runtime_error&){
+          drained = false;
+        }
+      }
+      // note: 完了を待てなかった場合は，カーネルがまだ書き込むかもしれないので，バッファとリングを解放せずに手放す（意図的なリーク）．
+      if(drained){
+        if(sqes_ != nullptr) ::munmap(sqes_, sqes_size_);
+        if(cq_ring_ != nullptr && cq_ring_ != sq_ring_) ::munmap(cq_ring_, cq_ring_size_);
+        if(sq_ring_ != nullptr) ::munmap(sq_ring_, sq_ring_size_);
+        std::free(buffers_);
+      }
+      if(ring_fd_ >= 0) ::close(ring_fd_);
+      sqes_ = nullptr;
+      cq_ring_ = nullptr;
+      sq_ring_ = nullptr;
+      ring_fd_ = -1;
+      buffers_ = nullptr;
+    }
+
+    void setup(std::size_t depth)
+    {
+      ::io_uring_params params;
+      std::memset(&params, 0, sizeof(params));
+      ring_fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, static_cast<unsigned>(depth), &params));
+      if(ring_fd_ < 0) throw std::runtime_error("io_uring_setup() failure.");
+      sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+      cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(::io_uring_cqe);
+      if(params.features & IORING_FEAT_SINGLE_MMAP){
+        sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+      }
+      void* p = ::mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+      if(p == MAP_FAILED) throw std::runtime_error("mmap() failure.");
+      sq_ring_ = p;
+      if(params.features & IORING_FEAT_SINGLE_MMAP){
+        cq_ring_ = sq_ring_;
+      }else{
+        p = ::mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+        if(p == MAP_FAILED) throw std::runtime_error("mmap() failure.");
+        cq_ring_ = p;
+      }
+      sqes_size_ = params.sq_entries * sizeof(::io_uring_sqe);
+      p = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+      if(p == MAP_FAILED) throw std::runtime_error("mmap() failure.");
+      sqes_ = static_cast<::io_uring_sqe*>(p);
+      auto sq = static_cast<char*>(sq_ring_);
+      auto cq = static_cast<char*>(cq_ring_);
+      sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+      sq_mask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+      sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+      cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+      cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+      cq_mask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+      cqes_ = reinterpret_cast<::io_uring_cqe*>(cq + params.cq_off.cqes);
+      //
+      if(::posix_memalign(reinterpret_cast<void**>(&buffers_), alignment, buffer_size_ * depth) != 0){
+        buffers_ = nullptr;
+        throw std::bad_alloc();
+      }
+      slots_.resize(depth);
+      std::vector<::iovec> iovecs(depth);
+      for(std::size_t i = 0; i < depth; ++i){
+        slots_[i].buffer_ = buffers_ + buffer_size_ * i;
+        slots_[i].iovec_.iov_base = slots_[i].buffer_;
+        slots_[i].iovec_.iov_len = buffer_size_;
+        slots_[i].pending_ = false;
+        iovecs[i] = slots_[i].iovec_;
+      }
+      // note: バッファの登録に失敗した場合（RLIMIT_MEMLOCK など）は，登録せずに readv で読み込む．
+      registered_ = ::syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_BUFFERS, iovecs.data(), static_cast<unsigned>(depth)) == 0;
+    }
+
+  public:
+
+    /// fd の所有権を引き取る．io_uring が使えない場合は fd を閉じずに例外を送出する．
+    BinaryUringReader(int fd, std::size_t file_size, std::size_t buffer_size, std::size_t depth):
+      fd_(fd), ring_fd_(-1), sq_ring_(nullptr), sq_ring_size_(0), cq_ring_(nullptr), cq_ring_size_(0), sqes_(nullptr), sqes_size_(0),
+      sq_tail_(nullptr), sq_mask_(nullptr), sq_array_(nullptr), cq_head_(nullptr), cq_tail_(nullptr), cq_mask_(nullptr), cqes_(nullptr),
+      registered_(false), file_size_(file_size), buffer_size_(std::max<std::size_t>((buffer_size + alignment - 1) / alignment * alignment, alignment)),
+      buffers_(nullptr), slots_(), next_offset_(0), to_submit_(0), in_flight_(0),
+      current_index_(0), holding_(false), current_(nullptr), current_size_(0)
+    {
+      depth = std::clamp<std::size_t>(depth, 1, 4096);
+      try{
+        setup(depth);
+        for(std::size_t i = 0; i < depth; ++i){
+          push(i, next_offset_);
+          next_offset_ += buffer_size_;
+        }
+        to_submit_ -= enter(to_submit_, 0);
+      }catch(...){
+        release();
+        throw;
+      }
+    }
+
+    ~BinaryUringReader() noexcept
+    {
+      close();
+    }
+
+    std::size_t min_buffer_size() const noexcept override
+    {
+      return buffer_size_;
+    }
+
+    std::size_t operator()(char* buffer, std::size_t limit) override
+    {
+      auto [first, n] = map(limit);
+      std::memcpy(buffer, first, n);
+      return n;
+    }
+
+    bool mappable() const noexcept override
+    {
+      return true;
+    }
+
+    std::tuple<const char*, std::size_t> map(std::size_t limit) override
+    {
+      if(ring_fd_ < 0) return {nullptr, 0};
+      if(current_size_ == 0){
+        if(holding_){
+          // 処理し終えたスロットで次の読み込みを発行する．
+          push(current_index_, next_offset_);
+          next_offset_ += buffer_size_;
+          current_index_ = (current_index_ + 1) % slots_.size();
+          holding_ = false;
+        }
+        auto& slot = slots_[current_index_];
+        {
+          ACCIO_STATISTICS_TIMER(read_wait_ns);
+          wait(current_index_);
+          while(slot.result_ == -EINTR || slot.result_ == -EAGAIN){
+            push(current_index_, slot.offset_);
+            wait(current_index_);
+          }
+        }
+        if(slot.result_ < 0) throw std::runtime_error("read() failure.");
+        auto n = static_cast<std::size_t>(slot.result_);
+        // note: 短い読み込みは稀なので，残りは同期的に読み込む．
+        // O_DIRECT で開いている場合があるので，読み込み済みの末尾の整列していない部分から整列した長さで読み直す．
+        while(n > 0 && n < slot.expected_){
+          auto aligned = n / alignment * alignment;
+          auto ret = ::pread(fd_, slot.buffer_ + aligned, buffer_size_ - aligned, slot.offset_ + aligned);
+          if(ret < 0) throw std::runtime_error("read() failure.");
+          if(static_cast<std::size_t>(ret) <= n - aligned) break;
+          n = aligned + static_cast<std::size_t>(ret);
+        }
+        n = std::min(n, slot.expected_);
+        ACCIO_STATISTICS_ADD(read_calls, 1);
+        ACCIO_STATISTICS_ADD(bytes_read, n);
+        if(n == 0) return {nullptr, 0};
+        holding_ = true;
+        current_ = slot.buffer_;
+        current_size_ = n;
+      }
+      auto n = std::min(limit, current_size_);
+      const char* result = current_;
+      current_ += n;
+      current_size_ -= n;
+      return {result, n};
+    }
+
+    void close() noexcept override
+    {
+      release();
+      if(fd_ >= 0){
+        auto ret = ::close(fd_);
+        // note: close のエラーはデバッグ時のみ捕捉する．
+        assert(ret == 0); static_cast<void>(ret);
+        fd_ = -1;
+      }
+      current_ = nullptr;
+      current_size_ = 0;
+    }
+
+  // deleted:
+
+    BinaryUringReader(BinaryUringReader&&) = delete;
+    BinaryUringReader(const BinaryUringReader&) = delete;
+    BinaryUringReader& operator=(BinaryUringReader&&) = delete;
+    BinaryUringReader& operator=(const BinaryUringReader&) = delete;
+
+  };
+
+  std::unique_ptr<BinaryReader> make_binary_uring_reader(const std::string& file_path, std::size_t buffer_size, std::size_t depth, bool direct)
+  {
+    int fd = -1;
+    if(direct){
+      // note: O_DIRECT に対応していないファイルシステムでは open が失敗するので，通常の方法で開き直す．
+      fd = ::open(file_path.c_str(), O_RDONLY | O_DIRECT);
+    }
+    if(fd < 0){
+      fd = ::open(file_path.c_str(), O_RDONLY);
+    }
+    if(fd < 0) throw std::runtime_error("Cannot open \"" + file_path + "\".");
+    struct stat st;
+    if(::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0){
+      try{
+        return std::make_unique<BinaryUringReader>(fd, static_cast<std::size_t>(st.st_size), buffer_size, depth);
+      }catch(const std::runtime_error&){
+        // io_uring が使えない場合はフォールバックする．
+      }catch(...){
+        // note: コンストラクタは fd を閉じずに例外を送出するので，ここで閉じる（std::bad_alloc など）．
+        ::close(fd);
+        throw;
+      }
+    }
+    // note: read() によるフォールバックではバッファの整列を保証しないので，O_DIRECT を外す．
+    auto flags = ::fcntl(fd, F_GETFL);
+    if(flags >= 0 && (flags & O_DIRECT)){
+      ::fcntl(fd, F_SETFL, flags & ~O_DIRECT);
+    }
+    return std::make_unique<BinaryFileReader>(fd);
+  }
+
+}
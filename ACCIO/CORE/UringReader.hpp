@@ -0,0 +1,19 @@
+#ifndef ACCIO_CORE_URINGREADER_HPP_
+#define ACCIO_CORE_URINGREADER_HPP_
+
+
+#include "Reader.hpp"
+
+
+namespace ACCIO::CORE
+{
+
+  /// io_uring を用いて buffer_size バイトの読み込みを最大 depth 個並行して発行する BinaryReader を作成する．
+  /// direct が true の場合は O_DIRECT で開く（ファイルシステムが対応していなければ無視する）．
+  /// io_uring が使えない環境や通常のファイル以外では make_binary_file_reader と同様に振る舞う．
+  std::unique_ptr<BinaryReader> make_binary_uring_reader(const std::string& file_path, std::size_t buffer_size, std::size_t depth, bool direct = false);
+
+}
+
+
+#endif
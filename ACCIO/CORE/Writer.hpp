@@ -0,0 +1,61 @@
+#ifndef ACCIO_CORE_WRITER_HPP_
+#define ACCIO_CORE_WRITER_HPP_
+
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include "AlignedBuffer.hpp"
+#include "char8_t.hpp"
+
+
+namespace ACCIO::CORE
+{
+
+  template<class CharT>
+  class Writer
+  {
+  public:
+
+    using char_type = CharT;
+
+    virtual ~Writer() = default;
+
+    /// 1 回の書き込みで渡すと効率のよい要素数を返す．OutputStream はこれをバッファの大きさの既定値とする．
+    virtual std::size_t preferred_buffer_size() const noexcept = 0;
+
+    /// [data, data + n) をすべて書き込む．
+    virtual void operator()(const char_type* data, std::size_t n) = 0;
+
+    /// 埋めたバッファをコピーせずに引き取れる場合は true を返す．
+    virtual bool swappable() const noexcept
+    {
+      return false;
+    }
+
+    /// buffer（capacity 要素）の先頭 n 要素を書き込むバッファとして引き取り，代わりに書き込み終えた capacity 要素以上のバッファを buffer に返す（swappable() が true の場合のみ呼び出せる）．
+    /// note: 例外を送出した場合は buffer を変更しない．
+    virtual void swap_buffer(AlignedArray<char_type>& buffer, std::size_t capacity, std::size_t n)
+    {
+      static_cast<void>(buffer);
+      static_cast<void>(capacity);
+      static_cast<void>(n);
+      throw std::logic_error("swap_buffer() is not supported.");
+    }
+
+    /// それまでに渡した内容の書き込みを完了させる．
+    virtual void flush()
+    {
+      // 何もしない．
+    }
+
+    virtual void close() noexcept = 0;
+
+  };
+
+  using BinaryWriter = Writer<char>;
+
+}
+
+#endif
@@ -2,20 +2,143 @@
 #define ACCIO_IO_HPP_
 
 
+#include "CORE/BinaryFDReader.hpp"
+#include "CORE/BinaryFDWriter.hpp"
 #include "CORE/BinaryFileReader.hpp"
+#include "CORE/BinaryFileWriter.hpp"
 #include "CORE/Decoder.hpp"
+#include "CORE/DecompressingReader.hpp"
 #include "CORE/InputStream.hpp"
+#include "CORE/OutputStream.hpp"
+#include "CORE/PrefetchReader.hpp"
+#include "CORE/U8Decoder.hpp"
+#include "CORE/UringReader.hpp"
+#include <limits>
 
 
 namespace ACCIO
 {
 
-  struct InputMode {} IN;
+  /// buffer_size バイト（0 の場合はファイルの大きさと st_blksize から決める）のバッファに読み込む．
+  /// adaptive が true の場合は，読み込みがバッファをほぼ満たし続ける間バッファを大きくする．
+  struct InputMode
+  {
+    std::size_t buffer_size = 0;
+    bool adaptive = false;
+  };
+
+  inline constexpr InputMode IN{};
+
+  /// ファイルをメモリにマップして読み込む．マップできないファイルでは IN と同様に振る舞う．
+  /// buffer_size は一度に参照する領域の大きさ（0 の場合は既定値）である．
+  struct MappedInputMode
+  {
+    std::size_t buffer_size = 0;
+    bool adaptive = false;
+  };
+
+  inline constexpr MappedInputMode IN_MAPPED{};
+
+  /// 別スレッドで先読みしながら読み込む．buffer_size バイトのバッファを depth 個用いる．
+  struct PrefetchInputMode
+  {
+    std::size_t buffer_size = 1 << 20;
+    std::size_t depth = 2;
+  };
+
+  inline constexpr PrefetchInputMode IN_PREFETCH{};
+
+  /// io_uring で buffer_size バイトの読み込みを最大 depth 個並行して発行しながら読み込む．
+  /// io_uring が使えない環境では IN と同様に振る舞う．
+  struct UringInputMode
+  {
+    std::size_t buffer_size = 1 << 20;
+    std::size_t depth = 4;
+    bool direct = false;
+  };
+
+  inline constexpr UringInputMode IN_URING{};
+
+  /// gzip, zstd, lz4 で圧縮されたファイルを展開しながら読み込む．圧縮形式は先頭のマジックナンバーから判定し，圧縮されていない場合はそのまま読み込む．
+  /// depth が 0 でなければ，展開は別スレッドで先読みしながら行う（IN_PREFETCH と同様に buffer_size バイトのバッファを depth 個用いる）．
+  /// threads は複数のフレームからなる zstd 形式を並行に展開するスレッドの数で，0 の場合はハードウェアのスレッド数とする．
+  struct CompressedInputMode
+  {
+    std::size_t buffer_size = 1 << 20;
+    std::size_t depth = 2;
+    std::size_t threads = 0;
+  };
+
+  inline constexpr CompressedInputMode IN_COMPRESSED{};
+
+  /// ファイルの [first, last) のバイト範囲のみを読み込む（CORE::CSVIndex で求めたレコードの位置から読む場合等）．
+  /// mapped が true の場合はファイルをメモリにマップして読み込む．
+  struct RangeInputMode
+  {
+    std::uint64_t first = 0;
+    std::uint64_t last = std::numeric_limits<std::uint64_t>::max();
+    bool mapped = true;
+    std::size_t buffer_size = 0;
+  };
+
+  namespace DETAIL
+  {
+
+    inline std::unique_ptr<CORE::BinaryReader> make_decompressing_reader(std::unique_ptr<CORE::BinaryReader>&& binary_reader, CompressedInputMode mode)
+    {
+      auto reader = CORE::make_binary_decompressing_reader(std::move(binary_reader), mode.threads);
+      if(mode.depth == 0) return reader;
+      return CORE::make_binary_prefetch_reader(std::move(reader), mode.buffer_size, mode.depth);
+    }
+
+  }
+
+  template<class CharT>
+  CORE::InputStream<CharT> open(const std::string& file_path, InputMode mode, const std::string& encoding = "ascii")
+  {
+    return CORE::InputStream<CharT>(CORE::make_decoder<CharT>(CORE::make_binary_file_reader(file_path), encoding), mode.buffer_size, mode.adaptive);
+  }
+
+  template<class CharT>
+  CORE::InputStream<CharT> open(const std::string& file_path, MappedInputMode mode, const std::string& encoding = "ascii")
+  {
+    return CORE::InputStream<CharT>(CORE::make_decoder<CharT>(CORE::make_binary_mmap_reader(file_path), encoding), mode.buffer_size, mode.adaptive);
+  }
+
+  template<class CharT>
+  CORE::InputStream<CharT> open(const std::string& file_path, PrefetchInputMode mode, const std::string& encoding = "ascii")
+  {
+    return CORE::InputStream<CharT>(CORE::make_decoder<CharT>(
+      CORE::make_binary_prefetch_reader(CORE::make_binary_file_reader(file_path), mode.buffer_size, mode.depth), encoding));
+  }
+
+  template<class CharT>
+  CORE::InputStream<CharT> open(const std::string& file_path, UringInputMode mode, const std::string& encoding = "ascii")
+  {
+    return CORE::InputStream<CharT>(CORE::make_decoder<CharT>(
+      CORE::make_binary_uring_reader(file_path, mode.buffer_size, mode.depth, mode.direct), encoding));
+  }
 
   template<class CharT>
-  CORE::InputStream<CharT> open(const std::string& file_path, InputMode, const std::string& encoding = "ascii")
+  CORE::InputStream<CharT> open(const std::string& file_path, CompressedInputMode mode, const std::string& encoding = "ascii")
   {
-    return CORE::InputStream<CharT>(CORE::make_decoder<CharT>(CORE::make_binary_file_reader(file_path), encoding));
+    return CORE::InputStream<CharT>(CORE::make_decoder<CharT>(DETAIL::make_decompressing_reader(CORE::make_binary_mmap_reader(file_path), mode), encoding));
+  }
+
+  template<class CharT>
+  CORE::InputStream<CharT> open(const std::string& file_path, RangeInputMode mode, const std::string& encoding = "ascii")
+  {
+    auto reader = mode.mapped ? CORE::make_binary_mmap_reader(file_path, mode.first, mode.last) : CORE::make_binary_file_reader(file_path, mode.first, mode.last);
+    return CORE::InputStream<CharT>(CORE::make_decoder<CharT>(std::move(reader), encoding), mode.buffer_size);
+  }
+
+  /// デコーダ（CORE::U8DecoderFromUTF8 等）と読み込み元（CORE::BinaryFileReader, CORE::BinaryMappedFileReader）を型で指定して開く．
+  /// 型消去を行わないので，読み込みは仮想関数呼び出しを介さない．
+  template<template<class> class DecoderT, class BinaryReaderT>
+  CORE::InputStream<char8_t, DecoderT<std::unique_ptr<BinaryReaderT>>> open(const std::string& file_path)
+  {
+    using Decoder = DecoderT<std::unique_ptr<BinaryReaderT>>;
+    return CORE::InputStream<char8_t, Decoder>(std::make_unique<Decoder>(std::make_unique<BinaryReaderT>(file_path)));
   }
 
   template<class CharT>
@@ -24,6 +147,59 @@ namespace ACCIO
     return CORE::InputStream<CharT>(CORE::make_decoder<CharT>(CORE::make_binary_stdin_reader(), encoding));
   }
 
+  template<class CharT>
+  CORE::InputStream<CharT> stdin(InputMode mode, const std::string& encoding = "ascii")
+  {
+    return CORE::InputStream<CharT>(CORE::make_decoder<CharT>(CORE::make_binary_stdin_reader(), encoding), mode.buffer_size, mode.adaptive);
+  }
+
+  template<class CharT>
+  CORE::InputStream<CharT> stdin(CompressedInputMode mode, const std::string& encoding = "ascii")
+  {
+    return CORE::InputStream<CharT>(CORE::make_decoder<CharT>(DETAIL::make_decompressing_reader(CORE::make_binary_stdin_reader(), mode), encoding));
+  }
+
+  template<class CharT>
+  CORE::InputStream<CharT> stdin(PrefetchInputMode mode, const std::string& encoding = "ascii")
+  {
+    return CORE::InputStream<CharT>(CORE::make_decoder<CharT>(
+      CORE::make_binary_prefetch_reader(CORE::make_binary_stdin_reader(), mode.buffer_size, mode.depth), encoding));
+  }
+
+  /// buffer_size バイトのバッファに溜めてから書き込む．
+  /// depth が 0 でなければ，書き込みは別スレッドで行う（buffer_size バイトのバッファを更に depth 個用いる）．
+  struct OutputMode
+  {
+    std::size_t buffer_size = 1 << 20;
+    std::size_t depth = 0;
+  };
+
+  inline constexpr OutputMode OUT{};
+
+  namespace DETAIL
+  {
+
+    inline std::unique_ptr<CORE::BinaryWriter> make_writer(std::unique_ptr<CORE::BinaryWriter>&& binary_writer, OutputMode mode)
+    {
+      if(mode.depth == 0) return std::move(binary_writer);
+      return CORE::make_binary_background_writer(std::move(binary_writer), mode.buffer_size, mode.depth);
+    }
+
+  }
+
+  /// file_path を作成（既にある場合は空に）して書き込む．
+  template<class CharT>
+  CORE::OutputStream<CharT> create(const std::string& file_path, OutputMode mode = OUT)
+  {
+    return CORE::OutputStream<CharT>(DETAIL::make_writer(CORE::make_binary_file_writer(file_path), mode), mode.buffer_size);
+  }
+
+  template<class CharT>
+  CORE::OutputStream<CharT> stdout(OutputMode mode = OUT)
+  {
+    return CORE::OutputStream<CharT>(DETAIL::make_writer(CORE::make_binary_stdout_writer(), mode), mode.buffer_size);
+  }
+
 }
 
 
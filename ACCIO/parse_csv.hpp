@@ -2,9 +2,19 @@
 #define ACCIO_PARSECSV_HPP_
 
 
+#include "CORE/AsyncCSVParser.hpp"
+#include "CORE/BinaryFileReader.hpp"
+#include "CORE/CSVIndex.hpp"
 #include "CORE/CSVParser.hpp"
+#include "CORE/CSVPipeline.hpp"
+#include "CORE/CSVWriter.hpp"
+#include "CORE/Decoder.hpp"
+#include "CORE/MultiFileCSVParser.hpp"
+#include "CORE/ParallelCSVParser.hpp"
+#include "CORE/RecordBatch.hpp"
 #include <iterator>
 #include <istream>
+#include <limits>
 
 
 namespace ACCIO
@@ -18,6 +28,118 @@ namespace ACCIO
     return CORE::CSVParser<char_type>(std::forward<InputT>(input), delimiter);
   }
 
+  template<class InputT, class CharT>
+  decltype(auto) parse_csv(InputT&& input, const CORE::CSVOptions<CharT>& options)
+  {
+    return CORE::CSVParser<CharT>(std::forward<InputT>(input), options);
+  }
+
+  /// 各レコードを SchemaT（CORE::Schema<int, double, std::string_view> 等）に従って std::tuple に変換しながら解析する．
+  template<class SchemaT, class InputT, std::enable_if_t<CORE::is_schema<SchemaT>::value>* = nullptr>
+  decltype(auto) parse_csv(InputT&& input, char8_t delimiter = ',')
+  {
+    using std::begin;
+    using char_type = std::remove_cv_t<std::remove_reference_t<decltype(*begin(std::declval<InputT&>()))>>;
+    return CORE::TypedCSVParser<SchemaT, CORE::CSVParser<char_type>>(std::forward<InputT>(input), delimiter);
+  }
+
+  template<class SchemaT, class InputT, class CharT, std::enable_if_t<CORE::is_schema<SchemaT>::value>* = nullptr>
+  decltype(auto) parse_csv(InputT&& input, const CORE::CSVOptions<CharT>& options)
+  {
+    return CORE::TypedCSVParser<SchemaT, CORE::CSVParser<CharT>>(std::forward<InputT>(input), options);
+  }
+
+  /// 型消去を行わずに input を解析する．input は peek_span() と consume() を持つ必要がある．
+  template<class InputT>
+  CORE::StaticCSVParser<InputT> parse_csv_static(InputT&& input, const CORE::CSVOptions<typename std::remove_reference_t<InputT>::char_type>& options = {})
+  {
+    return CORE::StaticCSVParser<InputT>(std::forward<InputT>(input), options);
+  }
+
+  /// DialectT（CORE::CSVDialect, CORE::TSVDialect 等）に特化した解析を行う．options の方言に関する指定は無視される．
+  template<class DialectT, class InputT>
+  CORE::StaticCSVParser<InputT, DialectT> parse_csv_static(InputT&& input, const CORE::CSVOptions<typename std::remove_reference_t<InputT>::char_type>& options = {})
+  {
+    return CORE::StaticCSVParser<InputT, DialectT>(std::forward<InputT>(input), options);
+  }
+
+  /// index を用いて file_path の record 番目のレコードから解析する．
+  /// 記録されたレコードの位置からファイルを読み始めるので，その手前のレコードは読まない．
+  /// note: options.column_names と options.header は指定できない（record 番目のレコードがヘッダとして扱われる）．
+  template<class CharT = char8_t>
+  CORE::CSVParser<CharT> parse_csv_at(const std::string& file_path, const CORE::CSVIndex& index, std::uint64_t record,
+                                      const std::string& encoding = "ascii", const CORE::CSVOptions<CharT>& options = {})
+  {
+    auto [offset, skip] = index.locate(record);
+    auto reader = CORE::make_binary_mmap_reader(file_path, offset, std::numeric_limits<std::uint64_t>::max());
+    CORE::CSVParser<CharT> parser(CORE::InputStream<CharT>(CORE::make_decoder<CharT>(std::move(reader), encoding)), options);
+    for(auto it = parser.begin(); skip != 0 && it != parser.end(); --skip){
+      ++it;
+    }
+    return parser;
+  }
+
+  /// input を専用のスレッドで解析し，レコードを再利用するバッファに詰めて pop() で渡す CSVPipeline を作成する．
+  /// QueueT には，pop() を 1 つのスレッドからのみ呼ぶ場合は CORE::SPSCQueue を，複数のスレッドから呼ぶ場合は CORE::MPMCQueue を指定する．
+  template<template<class> class QueueT = CORE::MPMCQueue, class InputT,
+           class CharT = std::remove_cv_t<std::remove_reference_t<decltype(*std::begin(std::declval<InputT&>()))>>,
+           class PipelineT = CORE::CSVPipeline<CORE::CSVParser<CharT>, QueueT>>
+  PipelineT parse_csv_pipelined(InputT&& input, const CORE::CSVOptions<CharT>& options = {},
+                                std::size_t buffers = PipelineT::default_buffers, std::size_t batch_size = PipelineT::default_batch_size)
+  {
+    return PipelineT(CORE::CSVParser<CharT>(std::forward<InputT>(input), options), buffers, batch_size);
+  }
+
+  /// output に CSV を書き込む CSVWriter を作成する．
+  template<class OutputT>
+  CORE::CSVWriter<typename OutputT::char_type, OutputT> write_csv(OutputT&& output, typename OutputT::char_type delimiter = ',')
+  {
+    return CORE::CSVWriter<typename OutputT::char_type, OutputT>(std::move(output), delimiter);
+  }
+
+  /// ファイルを chunk_size バイト程度ずつに分割して threads 個のスレッドで並行に解析する．threads が 0 の場合はハードウェアのスレッド数を用いる．
+  template<class CharT = char8_t>
+  CORE::ParallelCSVParser<CharT> parse_csv_parallel(const std::string& file_path, const std::string& encoding = "ascii", char8_t delimiter = ',', std::size_t threads = 0,
+                                                    std::size_t chunk_size = CORE::ParallelCSVParser<CharT>::default_chunk_size)
+  {
+    return CORE::ParallelCSVParser<CharT>(file_path, encoding, delimiter, threads, chunk_size);
+  }
+
+  /// index で記録したレコードの位置でファイルを chunk_size バイト程度ずつに分割して並行に解析する．
+  template<class CharT = char8_t>
+  CORE::ParallelCSVParser<CharT> parse_csv_parallel(const std::string& file_path, const CORE::CSVIndex& index, const std::string& encoding = "ascii",
+                                                    char8_t delimiter = ',', std::size_t threads = 0,
+                                                    std::size_t chunk_size = CORE::ParallelCSVParser<CharT>::default_chunk_size)
+  {
+    return CORE::ParallelCSVParser<CharT>(file_path, index, encoding, delimiter, threads, chunk_size);
+  }
+
+  /// file_paths のファイルを threads 個のスレッドで並行に解析する．threads が 0 の場合はハードウェアのスレッド数を用いる．
+  template<class CharT = char8_t>
+  CORE::MultiFileCSVParser<CharT> parse_csv_files(std::vector<std::string> file_paths, const std::string& encoding = "ascii",
+                                                  const CORE::CSVOptions<CharT>& options = {}, std::size_t threads = 0)
+  {
+    return CORE::MultiFileCSVParser<CharT>(std::move(file_paths), encoding, options, threads);
+  }
+
+  /// pattern（シェルのワイルドカード）に一致するファイルを並行に解析する．ファイルの番号は名前の順である．
+  template<class CharT = char8_t>
+  CORE::MultiFileCSVParser<CharT> parse_csv_glob(const std::string& pattern, const std::string& encoding = "ascii",
+                                                 const CORE::CSVOptions<CharT>& options = {}, std::size_t threads = 0)
+  {
+    return CORE::MultiFileCSVParser<CharT>(CORE::glob_files(pattern), encoding, options, threads);
+  }
+
+#ifdef ACCIO_CORE_HAS_COROUTINE
+  /// ノンブロッキングで読み込む fd（パイプ，ソケット等）を reactor の上で解析する AsyncCSVParser を作成する．fd の所有権を引き取る．
+  /// note: C++20 でコンパイルした場合のみ有効である．
+  template<class CharT = char8_t>
+  CORE::AsyncCSVParser<CharT> parse_csv_async(CORE::Reactor& reactor, int fd, const std::string& encoding = "ascii", const CORE::CSVOptions<CharT>& options = {})
+  {
+    return CORE::AsyncCSVParser<CharT>(CORE::AsyncInputStream<CharT>(reactor, fd), options, encoding);
+  }
+#endif
+
 }
 
 
@@ -0,0 +1,200 @@
+// 読み込みと解析の各段の速度を測る．
+// usage: bench FILE [REPEAT]
+// 各項目を REPEAT 回実行して最も速かった回の MB/s（入力のバイト数基準）と records/s を表示する．
+// ACCIO_ENABLE_STATISTICS を定義してコンパイルした場合は，各項目の最後の回の計測値を JSON で続けて表示する（make stats）．
+// note: BinaryMappedFileReader の項目はマップした領域を触らないので，ページフォルトの費用は含まない．
+#include "IO.hpp"
+#include "parse_csv.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+
+
+namespace
+{
+
+  using namespace ACCIO;
+
+  // 1 回分の処理を行い，レコード数（レコードを数えない項目では 0）を返す．
+  using Case = std::function<std::size_t(const std::string&)>;
+
+  // note: 結果を捨てる処理が最適化で消えないように書き込む．
+  volatile std::size_t sink;
+
+  std::size_t file_size(const std::string& path)
+  {
+    struct stat st;
+    if(::stat(path.c_str(), &st) != 0) throw std::runtime_error("Cannot open \"" + path + "\".");
+    return static_cast<std::size_t>(st.st_size);
+  }
+
+  // reader を EOF まで読み，読んだ要素数を返す．
+  template<class ReaderT>
+  std::size_t drain(ReaderT& reader)
+  {
+    std::size_t total = 0;
+    if(reader.mappable()){
+      while(auto n = std::get<1>(reader.map(1 << 20))){
+        total += n;
+      }
+    }else{
+      auto size = std::max<std::size_t>(reader.min_buffer_size(), 1 << 20);
+      std::unique_ptr<typename ReaderT::char_type[]> buffer(new typename ReaderT::char_type[size]);
+      while(auto n = reader(buffer.get(), size)){
+        total += n;
+      }
+    }
+    return total;
+  }
+
+  template<class ParserT>
+  std::size_t count_records(ParserT&& parser)
+  {
+    std::size_t records = 0;
+    for(auto&& record: parser){
+      records += record.size() != 0;
+    }
+    return records;
+  }
+
+  void run(const std::string& name, const Case& f, const std::string& path, std::size_t bytes, int repeat)
+  {
+    double best = 0;
+    std::size_t records = 0;
+    try{
+      for(int i = 0; i < repeat; ++i){
+        CORE::reset_statistics();
+        auto start = std::chrono::steady_clock::now();
+        records = f(path);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if(i == 0 || seconds < best) best = seconds;
+      }
+    }catch(const std::exception& e){
+      std::printf("%-28s %12s  (%s)\n", name.c_str(), "-", e.what());
+      return;
+    }
+    if(records != 0){
+      std::printf("%-28s %9.1f MB/s %12.0f records/s\n", name.c_str(), static_cast<double>(bytes) / best / 1e6, static_cast<double>(records) / best);
+    }else{
+      std::printf("%-28s %9.1f MB/s\n", name.c_str(), static_cast<double>(bytes) / best / 1e6);
+    }
+    if constexpr(CORE::statistics_enabled){
+      std::printf("  %s\n", CORE::statistics().to_json().c_str());
+    }
+  }
+
+}
+
+
+int main(int argc, char* argv[])
+{
+  if(argc < 2){
+    std::cerr << "usage: " << argv[0] << " FILE [REPEAT]" << std::endl;
+    return 1;
+  }
+  std::string path = argv[1];
+  int repeat = argc > 2 ? std::atoi(argv[2]) : 3;
+  std::size_t bytes = file_size(path);
+  std::printf("%s: %zu bytes\n", path.c_str(), bytes);
+
+  const std::pair<std::string, Case> cases[] = {
+    // 読み込み
+    {"BinaryFileReader", [](const std::string& p){ auto r = CORE::make_binary_file_reader(p); sink = drain(*r); return std::size_t(0); }},
+    {"BinaryMappedFileReader", [](const std::string& p){ auto r = CORE::make_binary_mmap_reader(p); sink = drain(*r); return std::size_t(0); }},
+    {"prefetch reader", [](const std::string& p){ auto r = CORE::make_binary_prefetch_reader(CORE::make_binary_file_reader(p), 1 << 20, 2); sink = drain(*r); return std::size_t(0); }},
+    {"uring reader", [](const std::string& p){ auto r = CORE::make_binary_uring_reader(p, 1 << 20, 4); sink = drain(*r); return std::size_t(0); }},
+    // デコーダ
+    {"decoder ascii", [](const std::string& p){ auto r = CORE::make_decoder<char8_t>(CORE::make_binary_file_reader(p), "ascii"); sink = drain(*r); return std::size_t(0); }},
+    {"decoder utf-8", [](const std::string& p){ auto r = CORE::make_decoder<char8_t>(CORE::make_binary_file_reader(p), "utf-8"); sink = drain(*r); return std::size_t(0); }},
+    {"decoder utf-8 (mapped)", [](const std::string& p){ auto r = CORE::make_decoder<char8_t>(CORE::make_binary_mmap_reader(p), "utf-8"); sink = drain(*r); return std::size_t(0); }},
+    {"decoder trusted-utf-8", [](const std::string& p){ auto r = CORE::make_decoder<char8_t>(CORE::make_binary_file_reader(p), "trusted-utf-8"); sink = drain(*r); return std::size_t(0); }},
+    // InputStream
+    {"InputStream iterator", [](const std::string& p){
+      std::size_t lines = 0;
+      for(auto c: open<char8_t>(p, IN_MAPPED, "utf-8")) lines += c == '\n';
+      sink = lines;
+      return std::size_t(0);
+    }},
+    {"InputStream for_each_chunk", [](const std::string& p){
+      std::size_t lines = 0;
+      open<char8_t>(p, IN_MAPPED, "utf-8").for_each_chunk([&](auto span){ lines += static_cast<std::size_t>(std::count(span.begin(), span.end(), '\n')); });
+      sink = lines;
+      return std::size_t(0);
+    }},
+    // CSVParser
+    {"CSVParser", [](const std::string& p){ return count_records(parse_csv(open<char8_t>(p, IN, "utf-8"))); }},
+    {"CSVParser (mapped)", [](const std::string& p){ return count_records(parse_csv(open<char8_t>(p, IN_MAPPED, "utf-8"))); }},
+    {"CSVParser (zero copy)", [](const std::string& p){ return count_records(parse_csv(open<char8_t>(p, IN_MAPPED, "utf-8"), CORE::CSVOptions<char8_t>{',', true})); }},
+    {"CSVParser (iterator impl)", [](const std::string& p){
+      auto stream = open<char8_t>(p, IN_MAPPED, "utf-8");
+      return count_records(CORE::CSVParser<char8_t>(stream.begin(), stream.end(), ','));
+    }},
+    {"StaticCSVParser", [](const std::string& p){
+      return count_records(parse_csv_static(open<CORE::U8DecoderFromUTF8, CORE::BinaryMappedFileReader>(p), CORE::CSVOptions<char8_t>{',', true}));
+    }},
+    {"StaticCSVParser (CSVDialect)", [](const std::string& p){
+      return count_records(parse_csv_static<CORE::CSVDialect>(open<CORE::U8DecoderFromUTF8, CORE::BinaryMappedFileReader>(p), CORE::CSVOptions<char8_t>{',', true}));
+    }},
+    // note: 以下の 2 つは区切り文字をタブとし，ダブルクォートを通常の文字として扱う（tsv 以外のファイルでは 1 レコードが 1 フィールドとなる）．
+    {"CSVParser (TSV options)", [](const std::string& p){
+      CORE::CSVOptions<char8_t> options{'\t', true};
+      options.quoting = false;
+      return count_records(parse_csv(open<char8_t>(p, IN_MAPPED, "utf-8"), options));
+    }},
+    {"StaticCSVParser (TSVDialect)", [](const std::string& p){
+      return count_records(parse_csv_static<CORE::TSVDialect>(open<CORE::U8DecoderFromUTF8, CORE::BinaryMappedFileReader>(p), CORE::CSVOptions<char8_t>{'\t', true}));
+    }},
+    // note: 以下の 2 つは先頭のレコードをヘッダとし，最後の列の長さの合計を求める．
+    {"CSVParser (by name)", [](const std::string& p){
+      CORE::CSVOptions<char8_t> options{',', true};
+      options.header = true;
+      auto parser = parse_csv(open<char8_t>(p, IN_MAPPED, "utf-8"), options);
+      auto name = parser.header()->size() != 0 ? parser.header()->names().back() : std::basic_string<char8_t>();
+      std::size_t records = 0, length = 0;
+      for(auto&& record: parser){
+        length += record[name].size();
+        ++records;
+      }
+      sink = length;
+      return records;
+    }},
+    {"CSVParser (ColumnRef)", [](const std::string& p){
+      CORE::CSVOptions<char8_t> options{',', true};
+      options.header = true;
+      auto parser = parse_csv(open<char8_t>(p, IN_MAPPED, "utf-8"), options);
+      auto column = parser.column(parser.header()->size() != 0 ? parser.header()->names().back() : std::basic_string<char8_t>());
+      std::size_t records = 0, length = 0;
+      for(auto&& record: parser){
+        length += record[column].size();
+        ++records;
+      }
+      sink = length;
+      return records;
+    }},
+    {"ParallelCSVParser", [](const std::string& p){
+      std::size_t records = 0;
+      parse_csv_parallel<char8_t>(p, "utf-8").for_each([&](auto&& record){ records += record.size() != 0; });
+      return records;
+    }},
+    // note: 1 スレッドで実行し，並行化のための処理の費用を逐次の CSVParser (mapped) と比べる．
+    {"ParallelCSVParser (1 thread)", [](const std::string& p){
+      std::size_t records = 0;
+      parse_csv_parallel<char8_t>(p, "utf-8", ',', 1).for_each([&](auto&& record){ records += record.size() != 0; });
+      return records;
+    }},
+    {"for_each_batch (1 thread)", [](const std::string& p){
+      std::size_t records = 0;
+      parse_csv_parallel<char8_t>(p, "utf-8", ',', 1).for_each_batch([&](auto&& batch){ records += batch.records_.size(); });
+      return records;
+    }},
+  };
+  for(auto&& [name, f]: cases){
+    run(name, f, path, bytes, repeat);
+  }
+  return 0;
+}
@@ -0,0 +1,154 @@
+// ベンチマーク用の CSV を生成する．
+// usage: generate_csv KIND SIZE [SEED] > FILE
+// 同じ引数からは常に同じ内容を生成する（乱数は std::mt19937_64 の出力を直接使い，分布クラスの実装に依存しない）．
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+
+namespace
+{
+
+  class Generator
+  {
+  private:
+
+    std::mt19937_64 random_;
+
+  public:
+
+    explicit Generator(std::uint64_t seed):
+      random_(seed)
+    {}
+
+    std::size_t uniform(std::size_t n)
+    {
+      return static_cast<std::size_t>(random_() % n);
+    }
+
+    void number(std::string& out)
+    {
+      out += std::to_string(static_cast<std::int64_t>(random_() >> uniform(60)) - (uniform(4) == 0 ? 1000 : 0));
+    }
+
+    void word(std::string& out, std::size_t min_length, std::size_t max_length)
+    {
+      static const char letters[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 _-.";
+      auto n = min_length + uniform(max_length - min_length + 1);
+      for(std::size_t i = 0; i < n; ++i){
+        out += letters[uniform(sizeof(letters) - 1)];
+      }
+    }
+
+    // 区切り文字，改行，ダブルクォートを含むダブルクォートで囲まれたフィールド．
+    void quoted(std::string& out)
+    {
+      out += '"';
+      auto n = 1 + uniform(24);
+      for(std::size_t i = 0; i < n; ++i){
+        switch(uniform(8)){
+        case 0: out += "\"\""; break;
+        case 1: out += ','; break;
+        case 2: out += '\n'; break;
+        default: word(out, 1, 6); break;
+        }
+      }
+      out += '"';
+    }
+
+    // 2 から 4 バイトの文字を混ぜた UTF-8 の文字列．
+    void multibyte(std::string& out)
+    {
+      static const char* const characters[] = {"あ", "漢", "字", "é", "ß", "Ω", "€", "😀", "한", "a", "b", " "};
+      auto n = 1 + uniform(16);
+      for(std::size_t i = 0; i < n; ++i){
+        out += characters[uniform(sizeof(characters) / sizeof(characters[0]))];
+      }
+    }
+
+    void record(const std::string& kind, std::string& out)
+    {
+      if(kind == "narrow"){
+        for(int i = 0; i < 8; ++i){
+          if(i != 0) out += ',';
+          if(i % 2 == 0) number(out); else word(out, 0, 12);
+        }
+        out += '\n';
+      }else if(kind == "wide"){
+        for(int i = 0; i < 200; ++i){
+          if(i != 0) out += ',';
+          number(out);
+        }
+        out += '\n';
+      }else if(kind == "quoted"){
+        for(int i = 0; i < 8; ++i){
+          if(i != 0) out += ',';
+          if(uniform(4) != 0) quoted(out); else word(out, 0, 8);
+        }
+        out += '\n';
+      }else if(kind == "crlf"){
+        for(int i = 0; i < 8; ++i){
+          if(i != 0) out += ',';
+          if(i % 2 == 0) number(out); else word(out, 0, 12);
+        }
+        out += "\r\n";
+      }else if(kind == "tsv"){
+        // note: 囲み文字を使わない TSV．フィールドはタブも改行も含まない．
+        for(int i = 0; i < 8; ++i){
+          if(i != 0) out += '\t';
+          if(i % 2 == 0) number(out); else word(out, 0, 12);
+        }
+        out += '\n';
+      }else if(kind == "utf8"){
+        for(int i = 0; i < 8; ++i){
+          if(i != 0) out += ',';
+          if(i % 2 == 0) number(out); else multibyte(out);
+        }
+        out += '\n';
+      }else if(kind == "long"){
+        for(int i = 0; i < 3; ++i){
+          if(i != 0) out += ',';
+          word(out, 1000, 100000);
+        }
+        out += '\n';
+      }else{
+        throw std::runtime_error("unknown kind \"" + kind + "\".");
+      }
+    }
+
+  };
+
+}
+
+
+int main(int argc, char* argv[])
+{
+  if(argc < 3){
+    std::cerr << "usage: " << argv[0] << " {narrow|wide|quoted|crlf|tsv|utf8|long} SIZE [SEED]" << std::endl;
+    return 1;
+  }
+  std::string kind = argv[1];
+  std::size_t size = std::strtoull(argv[2], nullptr, 10);
+  std::uint64_t seed = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 1;
+  Generator generator(seed);
+  std::string buffer;
+  std::size_t written = 0;
+  try{
+    while(written < size){
+      buffer.clear();
+      // note: 出力はレコード単位で区切るので，SIZE をわずかに超えることがある．
+      while(buffer.size() < (1 << 16) && written + buffer.size() < size){
+        generator.record(kind, buffer);
+      }
+      std::cout.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+      written += buffer.size();
+    }
+  }catch(const std::exception& e){
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
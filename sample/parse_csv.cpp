@@ -1,22 +1,305 @@
 #include "IO.hpp"
 #include "parse_csv.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+
+// note: C++20 では char8_t の文字列を std::cout に直接出力できないので，バイト列として出力する．
+template<class StringT>
+std::string_view bytes(const StringT& s)
+{
+  return std::string_view(reinterpret_cast<const char*>(s.data()), s.size());
+}
+
+// Schema で変換した値を，typed.csv のフィールドと同じ表記で出力する．
+template<class T>
+void print_value(const T& value)
+{
+  if constexpr(std::is_same_v<T, bool>){
+    std::cout << (value ? "true" : "false");
+  }else if constexpr(std::is_arithmetic_v<T>){
+    char buffer[64];
+    auto [last, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    static_cast<void>(ec);
+    std::cout << std::string_view(buffer, static_cast<std::size_t>(last - buffer));
+  }else if constexpr(std::is_same_v<T, ACCIO::CORE::Date>){
+    std::cout << std::setfill('0') << std::setw(4) << value.year << '-' << std::setw(2) << value.month << '-' << std::setw(2) << value.day << std::setfill(' ');
+  }else{
+    std::cout << bytes(value);
+  }
+}
+
+template<class T>
+void print_value(const std::optional<T>& value)
+{
+  if(value) print_value(*value);
+}
+
+// TypedRecordBatch の r 行目を出力する．null の要素は空として出力する．
+template<class BatchT, std::size_t... Is>
+void print_row(const BatchT& batch, std::size_t r, std::index_sequence<Is...>)
+{
+  ((batch.template column<Is>().is_valid(r) ? print_value(batch.template column<Is>()[r]) : void(), std::cout << '\t'), ...);
+  std::cout << std::endl;
+}
 
 
 int main(int argc, char* argv[])
 {
   using namespace ACCIO;
+  std::string mode = argc > 2 ? argv[2] : "in";
   std::size_t rows = 0;
   std::size_t elements = 0;
-  for(auto&& record: parse_csv(open<char8_t>(argv[1], ACCIO::IN, "utf-8"))){
-//  for(auto&& record: parse_csv(ACCIO::stdin<char8_t>("utf-8"))){  
-//  for(auto&& record: parse_csv(std::string("a,b,\n,c,d,e\n"))){
+  auto print = [&](auto&& record){
     ++rows;
     for(auto&& field: record){
-      std::cout << field << '\t';
+      std::cout << bytes(field) << '\t';
       ++elements;
     }
     std::cout << std::endl;
+  };
+  if(mode == "parallel"){
+    // 1，7，64 バイトずつに分割して（索引による分割も含めて）解析し，既定の分割で解析した結果と一致することを確かめる（表示は既定の分割の結果）．
+    auto collect = [](auto&& parser){
+      std::vector<std::vector<std::string>> table;
+      parser.for_each([&](auto&& record){
+        table.emplace_back();
+        for(auto&& field: record){
+          table.back().emplace_back(bytes(field));
+        }
+      });
+      return table;
+    };
+    auto table = collect(parse_csv_parallel<char8_t>(argv[1], "utf-8", ',', 3));
+    auto index = CORE::build_csv_index(argv[1], CORE::CSVIndexOptions{2});
+    for(std::size_t chunk_size: {1, 7, 64}){
+      if(collect(parse_csv_parallel<char8_t>(argv[1], "utf-8", ',', 3, chunk_size)) != table ||
+         collect(parse_csv_parallel<char8_t>(argv[1], index, "utf-8", ',', 3, chunk_size)) != table){
+        std::cerr << "parallel mismatch with chunk size " << chunk_size << std::endl;
+        return 1;
+      }
+    }
+    for(auto&& record: table){
+      print(record);
+    }
+  }else if(mode == "roundtrip"){
+    // 解析したレコードを CSVWriter で一時ファイルに書き込み，それを解析し直す．
+    char path[] = "/tmp/parse_csv_XXXXXX";
+    int fd = ::mkstemp(path);
+    if(fd < 0) return 1;
+    ::close(fd);
+    {
+      auto writer = write_csv(create<char8_t>(path, OutputMode{4096, 2}));
+      for(auto&& record: parse_csv(open<char8_t>(argv[1], IN, "utf-8"))){
+        writer.write_record(record);
+      }
+      writer.flush();
+    }
+    for(auto&& record: parse_csv(open<char8_t>(path, IN, "utf-8"))){
+      print(record);
+    }
+    // 文字列リテラル，文字，数値等を write_row で書き込み，読み直した内容が一致することを確かめる（表示はしない）．
+    {
+      auto writer = write_csv(create<char8_t>(path));
+      writer.write_row("a,b", 'c', u8"d\"e", std::string("f"), std::string_view("g\nh"), u8'i', 42, -1.5, true, std::optional<int>());
+      writer.flush();
+    }
+    const std::string_view expected[] = {"a,b", "c", "d\"e", "f", "g\nh", "i", "42", "-1.5", "true", ""};
+    std::size_t k = 0;
+    for(auto&& record: parse_csv(open<char8_t>(path, IN, "utf-8"))){
+      for(auto&& field: record){
+        if(k >= std::size(expected) || bytes(field) != expected[k]){
+          std::cerr << "write_row mismatch at field " << k << std::endl;
+          return 1;
+        }
+        ++k;
+      }
+    }
+    ::unlink(path);
+    if(k != std::size(expected)) return 1;
+  }else if(mode == "typed"){
+    // 各レコードを Schema に従って変換し，変換した値を出力し直す（typed.csv のみ）．
+    using Schema = CORE::Schema<int, double, bool, CORE::Date, std::optional<int>, std::basic_string_view<char8_t>>;
+    for(auto&& values: parse_csv<Schema>(open<char8_t>(argv[1], IN, "utf-8"))){
+      ++rows;
+      std::apply([&](const auto&... value){ ((print_value(value), std::cout << '\t', ++elements), ...); }, values);
+      std::cout << std::endl;
+    }
+  }else if(mode == "batch"){
+    // 2 個ずつのレコードを列ごとのバッチとして読み，各行の null でない要素を出力する．
+    auto parser = parse_csv(open<char8_t>(argv[1], IN, "utf-8"));
+    while(true){
+      auto batch = read_batch(parser, 2);
+      for(std::size_t r = 0; r < batch.num_rows(); ++r){
+        ++rows;
+        for(std::size_t i = 0; i < batch.num_columns(); ++i){
+          if(!batch.column(i).is_valid(r)) continue;
+          std::cout << bytes(batch.column(i)[r]) << '\t';
+          ++elements;
+        }
+        std::cout << std::endl;
+      }
+      if(batch.num_rows() < 2) break;
+    }
+  }else if(mode == "arena"){
+    // 1 つの ArenaRecordBatch を使い回して 2 個ずつのレコードを読む．
+    // note: Arena のブロックを小さくして，最初のバッチでは複数のブロックにまたがり，reset() で 1 つにまとめられるようにする．
+    auto parser = parse_csv(open<char8_t>(argv[1], IN, "utf-8"));
+    CORE::ArenaRecordBatch<char8_t> batch(16);
+    while(read_batch(parser, batch, 2) != 0){
+      for(auto&& record: batch){
+        print(record);
+      }
+    }
+  }else if(mode == "typed_batch"){
+    // 2 個ずつのレコードを Schema に従って変換したバッチとして読み，各行を出力し直す（typed.csv のみ）．
+    using Schema = CORE::Schema<int, double, bool, CORE::Date, std::optional<int>, std::basic_string_view<char8_t>>;
+    auto parser = parse_csv(open<char8_t>(argv[1], IN, "utf-8"));
+    while(true){
+      auto batch = CORE::read_batch<Schema>(parser, 2);
+      for(std::size_t r = 0; r < batch.num_rows(); ++r){
+        ++rows;
+        elements += batch.num_columns();
+        print_row(batch, r, std::make_index_sequence<batch.num_columns()>());
+      }
+      if(batch.num_rows() < 2) break;
+    }
+  }else if(mode == "static"){
+    for(auto&& record: parse_csv_static(open<CORE::U8DecoderFromUTF8, CORE::BinaryMappedFileReader>(argv[1]))){
+      print(record);
+    }
+  }else if(mode == "indexed"){
+    // 索引を使って各レコードをその位置から読み直す．
+    auto index = CORE::build_csv_index(argv[1], CORE::CSVIndexOptions{2});
+    for(std::uint64_t k = 0; k < index.records(); ++k){
+      auto parser = parse_csv_at<char8_t>(argv[1], index, k, "utf-8");
+      print(*parser.begin());
+    }
+  }else if(mode == "header"){
+    // ヘッダの名前であらかじめ解決した ColumnRef で各レコードの列を参照する．
+    CORE::CSVOptions<char8_t> options;
+    options.header = true;
+    auto parser = parse_csv(open<char8_t>(argv[1], IN, "utf-8"), options);
+    const auto& header = *parser.header();
+    if(header.size() != 0) print(header.names());
+    std::vector<CORE::ColumnRef> columns;
+    for(auto&& name: header.names()){
+      columns.push_back(parser.column(name));
+    }
+    for(auto&& record: parser){
+      ++rows;
+      for(std::size_t i = 0; i < record.size(); ++i){
+        std::cout << bytes(i < columns.size() ? record[columns[i]] : record[i]) << '\t';
+        ++elements;
+      }
+      std::cout << std::endl;
+    }
+  }else if(mode == "projection"){
+    // すべての列を順に，および逆順に取り出し，さらにヘッダの名前で逆順に取り出して，通常の解析結果と一致することを確かめる（表示は通常の解析結果）．
+    std::vector<std::vector<std::string>> table;
+    std::size_t width = 0;
+    for(auto&& record: parse_csv(open<char8_t>(argv[1], IN, "utf-8"))){
+      table.emplace_back();
+      for(auto&& field: record){
+        table.back().emplace_back(bytes(field));
+      }
+      width = std::max(width, record.size());
+    }
+    // options で解析した first_row 番目以降のレコードが，table の columns の列と一致するか．
+    auto check = [&](const CORE::CSVOptions<char8_t>& options, const std::vector<std::size_t>& columns, std::size_t first_row){
+      auto k = first_row;
+      for(auto&& record: parse_csv(open<char8_t>(argv[1], IN, "utf-8"), options)){
+        bool matched = k < table.size() && record.size() == columns.size();
+        for(std::size_t i = 0; matched && i < columns.size(); ++i){
+          matched = bytes(record[i]) == (columns[i] < table[k].size() ? table[k][columns[i]] : std::string());
+        }
+        if(!matched){
+          std::cerr << "projection mismatch at record " << k << std::endl;
+          return false;
+        }
+        ++k;
+      }
+      if(k == std::max(first_row, table.size())) return true;
+      std::cerr << "projection mismatch" << std::endl;
+      return false;
+    };
+    if(width != 0){
+      CORE::CSVOptions<char8_t> options;
+      for(std::size_t i = 0; i < width; ++i) options.columns.push_back(i);
+      if(!check(options, options.columns, 0)) return 1;
+      std::reverse(options.columns.begin(), options.columns.end());
+      if(!check(options, options.columns, 0)) return 1;
+      auto names = table.front();
+      std::sort(names.begin(), names.end());
+      if(std::adjacent_find(names.begin(), names.end()) == names.end()){
+        CORE::CSVOptions<char8_t> by_name;
+        std::vector<std::size_t> columns;
+        for(std::size_t i = table.front().size(); i != 0; --i){
+          const auto& name = table.front()[i - 1];
+          by_name.column_names.emplace_back(name.begin(), name.end());
+          columns.push_back(i - 1);
+        }
+        if(!check(by_name, columns, 1)) return 1;
+      }
+      // 同じ名前の列を 2 回指定した場合は例外となる．
+      if(!table.front().empty()){
+        const auto& name = table.front().front();
+        CORE::CSVOptions<char8_t> duplicate;
+        duplicate.column_names.assign(2, std::basic_string<char8_t>(name.begin(), name.end()));
+        try{
+          for(auto&& record: parse_csv(open<char8_t>(argv[1], IN, "utf-8"), duplicate)) static_cast<void>(record);
+          std::cerr << "duplicate column names accepted" << std::endl;
+          return 1;
+        }catch(const std::runtime_error&){
+        }
+      }
+    }
+    for(auto&& row: table){
+      print(row);
+    }
+  }else if(mode == "multifile"){
+    // 同じファイルを 3 つのファイルとして並行に解析し，先頭のファイルのレコードのみを表示する．
+    parse_csv_files<char8_t>({argv[1], argv[1], argv[1]}, "utf-8", {}, 2).for_each([&](std::size_t file_id, auto&& record){
+      if(file_id == 0) print(record);
+    });
+  }else if(mode == "pipeline"){
+    // 解析を別のスレッドで行い，2 個ずつのレコードのバッファを受け取る．
+    auto pipeline = parse_csv_pipelined<CORE::SPSCQueue>(open<char8_t>(argv[1], IN, "utf-8"), {}, 2, 2);
+    while(auto buffer = pipeline.pop()){
+      for(auto&& record: *buffer){
+        print(record);
+      }
+    }
+  }else if(mode == "dialect"){
+    for(auto&& record: parse_csv_static<CORE::CSVDialect>(open<CORE::U8DecoderFromUTF8, CORE::BinaryMappedFileReader>(argv[1]))){
+      print(record);
+    }
+  }else{
+    auto stream = mode == "mapped" ? open<char8_t>(argv[1], IN_MAPPED, "utf-8")
+                : mode == "prefetch" ? open<char8_t>(argv[1], PrefetchInputMode{4096, 3}, "utf-8")
+                : mode == "uring" ? open<char8_t>(argv[1], UringInputMode{4096, 3, true}, "utf-8")
+                : mode == "trusted" || mode == "zerocopy" ? open<char8_t>(argv[1], IN_MAPPED, "trusted-utf-8")
+                : mode == "compressed" ? open<char8_t>(argv[1], CompressedInputMode{4096, 3, 1}, "utf-8")
+                : mode == "compressed_parallel" ? open<char8_t>(argv[1], CompressedInputMode{4096, 3, 3}, "utf-8")
+                : mode == "adaptive" ? open<char8_t>(argv[1], InputMode{1, true}, "utf-8")
+                : open<char8_t>(argv[1], IN, "utf-8");
+    for(auto&& record: parse_csv(std::move(stream), CORE::CSVOptions<char8_t>{',', mode == "zerocopy"})){
+//  for(auto&& record: parse_csv(ACCIO::stdin<char8_t>("utf-8"))){  
+//  for(auto&& record: parse_csv(std::string("a,b,\n,c,d,e\n"))){
+      print(record);
+    }
   }
   std::cout << rows << " rows, " << elements << " elements." << std::endl;
   return 0;
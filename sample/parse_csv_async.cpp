@@ -0,0 +1,56 @@
+#include "parse_csv.hpp"
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+
+// 同じファイルを 3 本のパイプに少しずつ書き込み，1 つの Reactor の上で並行に解析して，先頭のパイプのレコードのみを表示する．
+int main(int argc, char* argv[])
+{
+  using namespace ACCIO;
+  if(argc < 2) return 1;
+  std::ifstream file(argv[1], std::ios::binary);
+  std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  static constexpr std::size_t pipes = 3;
+  static constexpr std::size_t chunk_size = 3;
+  std::size_t rows = 0;
+  std::size_t elements = 0;
+  CORE::Reactor reactor;
+  std::vector<std::thread> writers;
+  for(std::size_t i = 0; i < pipes; ++i){
+    int fds[2];
+    if(::pipe(fds) != 0) return 1;
+    writers.emplace_back([&content, fd = fds[1]]{
+      for(std::size_t j = 0; j < content.size(); j += chunk_size){
+        auto n = std::min(chunk_size, content.size() - j);
+        if(::write(fd, content.data() + j, n) != static_cast<ssize_t>(n)) break;
+        std::this_thread::yield();
+      }
+      ::close(fd);
+    });
+    reactor.spawn([](CORE::Reactor& reactor, int fd, bool print, std::size_t& rows, std::size_t& elements) -> CORE::Task<void> {
+      auto parser = parse_csv_async<char>(reactor, fd, "utf-8");
+      auto records = parser.records();
+      while(true){
+        auto record = co_await records.next();
+        if(record == nullptr) break;
+        if(!print) continue;
+        ++rows;
+        for(auto&& field: *record){
+          std::cout << field << '\t';
+          ++elements;
+        }
+        std::cout << std::endl;
+      }
+    }(reactor, fds[0], i == 0, rows, elements));
+  }
+  reactor.run();
+  for(auto&& writer: writers){
+    writer.join();
+  }
+  std::cout << rows << " rows, " << elements << " elements." << std::endl;
+  return 0;
+}